@@ -10,7 +10,9 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/highgui/highgui_c.h>
 #include <stddef.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
 
@@ -47,7 +49,8 @@ Assignment3::Assignment3(const string &dp, const int cva) :
 		std::cout << full_path.str() << General::VideoFile << std::endl;
 
 		assert(
-			General::fexists(full_path.str() + General::BackgroundImageFile)
+			(General::fexists(full_path.str() + General::BackgroundImageFile) ||
+				General::fexists(full_path.str() + General::BackgroundVideoFile))
 			&&
 			General::fexists(full_path.str() + General::VideoFile)
 		);
@@ -95,6 +98,11 @@ void Assignment3::showKeys()
 	cout << "i       : Show/hide camera numbers (Linux only)" << endl;
 	cout << "o       : Show/hide origin" << endl;
 	cout << "t       : Top view" << endl;
+	cout << "k       : New color models from the current frame" << endl;
+	cout << "l       : Start identification (tracking)" << endl;
+	cout << "w       : Write the trajectories to the data directory (csv and binary)" << endl;
+	cout << "f       : Photo-consistency refinement on/off" << endl;
+	cout << "a       : Pause/resume background adaptation" << endl;
 	cout << "1,2,3,4 : Switch camera #" << endl << endl;
 	cout << "Zoom with the scrollwheel while on the 3D scene" << endl;
 	cout << "Rotate the 3D scene with left click+drag" << endl << endl;
@@ -105,11 +113,47 @@ void Assignment3::showKeys()
  *   create it from the checkerboard video and the measured camera intrinsics
  * - After that initialize the scene rendering classes
  * - Run it!
+ *
+ * Option --ycrcb learns and segments the background models in YCrCb instead of HSV
+ * Option --cache <MB> sets the memory for recently decoded frames and their
+ * masks, shared by all cameras (default 1024, 0 turns the frame caches off)
+ * Option --raw reads the frames from a raw (uncompressed) copy of each video,
+ * made once, instead of decoding them
+ * Option --votes <v1,v2,..> sets the votes of each camera's foreground (default 1,
+ * 0 ignores the camera) and --min-votes <k> the votes a voxel needs to be kept
+ * (default: all cameras), for k of n carving
+ * Option --mask-scale <n> lets the cameras segment at down to 1 / n of the frame
+ * size where the voxels stay resolved (default 1: full resolution)
  */
 void Assignment3::run(int argc, char** argv)
 {
+	BackgroundModel::ColorSpace color_space = BackgroundModel::HSV;
+	size_t cache_mb = 1024;
+	bool raw_video = false;
+	vector<int> votes;
+	int min_votes = 0;
+	int max_mask_scale = 1;
+	for (int a = 1; a < argc; ++a)
+	{
+		if (string(argv[a]) == "--ycrcb") color_space = BackgroundModel::YCRCB;
+		else if (string(argv[a]) == "--cache" && a + 1 < argc) cache_mb = (size_t) max(atoi(argv[++a]), 0);
+		else if (string(argv[a]) == "--raw") raw_video = true;
+		else if (string(argv[a]) == "--min-votes" && a + 1 < argc) min_votes = atoi(argv[++a]);
+		else if (string(argv[a]) == "--mask-scale" && a + 1 < argc) max_mask_scale = max(atoi(argv[++a]), 1);
+		else if (string(argv[a]) == "--votes" && a + 1 < argc)
+		{
+			stringstream list(argv[++a]);
+			string vote;
+			while (getline(list, vote, ','))
+				votes.push_back(atoi(vote.c_str()));
+		}
+	}
+
 	for (int v = 0; v < m_cam_views_amount; ++v)
 	{
+		m_cam_views[v]->getBackgroundModel().setColorSpace(color_space);
+		m_cam_views[v]->getFrameCache().setCapacity(cache_mb * 1024 * 1024 / m_cam_views_amount);
+		m_cam_views[v]->setUseRawVideo(raw_video);
 		bool has_cam = Camera::detExtrinsics(m_cam_views[v]->getDataPath(), General::CheckerboadVideo,
 				General::IntrinsicsFile, m_cam_views[v]->getCamPropertiesFile());
 		assert(has_cam);
@@ -120,9 +164,12 @@ void Assignment3::run(int argc, char** argv)
 	destroyAllWindows();
 	namedWindow(VIDEO_WINDOW, CV_WINDOW_KEEPRATIO);
 
-	Reconstructor reconstructor(m_cam_views);
+	Reconstructor reconstructor(m_cam_views, max_mask_scale);
+	for (size_t v = 0; v < votes.size() && v < m_cam_views.size(); ++v)
+		reconstructor.setVotes(v, votes[v]);
+	if (min_votes > 0) reconstructor.setMinVotes(min_votes);
 	Scene3DRenderer scene3d(reconstructor, m_cam_views);
-	Glut glut(scene3d);
+	Glut glut(scene3d, m_data_path);
 
 #ifdef __linux__
 	glut.initializeLinux(SCENE_WINDOW.c_str(), argc, argv);
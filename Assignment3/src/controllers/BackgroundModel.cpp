@@ -0,0 +1,395 @@
+/*
+ * BackgroundModel.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "BackgroundModel.h"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/imgproc/types_c.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+static const int MODEL_VERSION = 2;           // Stored models of another version are learned again (1: linear hue statistics)
+static const double HUE_RADIANS = CV_PI / 90;  // 8 bit hue goes round the color circle in 180 steps
+
+/**
+ * Hue a minus hue b the short way round the color circle, in [-90, 90)
+ */
+static inline float hueDifference(
+		float a, float b)
+{
+	const float difference = a - b;
+	return difference + 180.f * ((difference < -90) - (difference >= 90));
+}
+
+/**
+ * Constructor
+ */
+BackgroundModel::BackgroundModel(
+		ColorSpace color_space)
+{
+	setColorSpace(color_space);
+}
+
+BackgroundModel::~BackgroundModel()
+{
+}
+
+/**
+ * Learn the model from (at most max_frames evenly spread frames of) a background video
+ * The frames are read first, the per pixel statistics are computed row-parallel
+ *
+ * Hue is an angle, 179 and 0 are neighbours: its mean is the circular mean
+ * (the direction of the summed unit vectors) and its variance is taken over
+ * the differences the short way round (see hueDifference())
+ */
+bool BackgroundModel::learn(
+		const string &video_file, int max_frames)
+{
+	VideoCapture video(video_file);
+	if (!video.isOpened())
+	{
+		cerr << "Unable to open background video: " << video_file << endl;
+		return false;
+	}
+
+	const int frame_amount = (int) video.get(CAP_PROP_FRAME_COUNT);
+	const int stride = frame_amount > max_frames ? frame_amount / max_frames : 1;
+
+	vector<Mat> frames;
+	Mat frame;
+	for (int f = 0; video.read(frame) && (int) frames.size() < max_frames; ++f)
+	{
+		if (f % stride != 0) continue;
+		frames.push_back(frame.clone());
+	}
+	video.release();
+
+	if (frames.empty())
+	{
+		cerr << "No frames in background video: " << video_file << endl;
+		return false;
+	}
+
+	int f;
+#pragma omp parallel for schedule(static) private(f)
+	for (f = 0; f < (int) frames.size(); ++f)
+		cvtColor(frames[f], frames[f], getConversion());
+
+	const Size size = frames[0].size();
+	const bool hsv = m_color_space == HSV;
+	m_mean = Mat(size, CV_32FC3);
+	m_variance = Mat(size, CV_32FC3);
+
+	int y;
+#pragma omp parallel for schedule(static) private(y)
+	for (y = 0; y < size.height; ++y)
+	{
+		vector<double> sum(size.width * 3, 0), sum_sq(size.width * 3, 0);
+		vector<double> hue_cos(hsv ? size.width : 0, 0), hue_sin(hsv ? size.width : 0, 0);
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			const uchar* row = frames[i].ptr<uchar>(y);
+			for (int x = 0; x < size.width * 3; ++x)
+			{
+				sum[x] += row[x];
+				sum_sq[x] += row[x] * row[x];
+			}
+			for (int x = 0; x < (int) hue_cos.size(); ++x)
+			{
+				hue_cos[x] += cos(row[3 * x] * HUE_RADIANS);
+				hue_sin[x] += sin(row[3 * x] * HUE_RADIANS);
+			}
+		}
+
+		float* mean = m_mean.ptr<float>(y);
+		float* variance = m_variance.ptr<float>(y);
+		for (int x = 0; x < size.width * 3; ++x)
+		{
+			const double m = sum[x] / frames.size();
+			mean[x] = (float) m;
+			variance[x] = (float) max(sum_sq[x] / frames.size() - m * m, 0.0);
+		}
+
+		if (!hsv) continue;
+
+		// Hue over again, around its circular mean
+		vector<double> hue_sq(size.width, 0);
+		for (int x = 0; x < size.width; ++x)
+		{
+			const double h = atan2(hue_sin[x], hue_cos[x]) / HUE_RADIANS;
+			mean[3 * x] = (float) (h < 0 ? h + 180 : h);
+		}
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			const uchar* row = frames[i].ptr<uchar>(y);
+			for (int x = 0; x < size.width; ++x)
+			{
+				const float difference = hueDifference(row[3 * x], mean[3 * x]);
+				hue_sq[x] += difference * difference;
+			}
+		}
+		for (int x = 0; x < size.width; ++x)
+			variance[3 * x] = (float) (hue_sq[x] / frames.size());
+	}
+
+	return true;
+}
+
+/**
+ * Read a model stored by save()
+ */
+bool BackgroundModel::load(
+		const string &file)
+{
+	FileStorage fs;
+	if (!fs.open(file, FileStorage::READ)) return false;
+
+	int version = 1, color_space = HSV;
+	if (!fs["Version"].empty()) fs["Version"] >> version;
+	if (!fs["ColorSpace"].empty()) fs["ColorSpace"] >> color_space;
+
+	Mat mean, variance;
+	fs["Mean"] >> mean;
+	fs["Variance"] >> variance;
+	fs.release();
+
+	// Learned in another color space or by another version
+	if (color_space != m_color_space || version != MODEL_VERSION) return false;
+
+	if (mean.empty() || mean.type() != CV_32FC3 || variance.size() != mean.size() || variance.type() != CV_32FC3)
+		return false;
+
+	m_mean = mean;
+	m_variance = variance;
+	return true;
+}
+
+/**
+ * Cache the model, so the background video only has to be learned once
+ */
+bool BackgroundModel::save(
+		const string &file) const
+{
+	FileStorage fs;
+	if (!fs.open(file, FileStorage::WRITE)) return false;
+
+	fs << "Version" << MODEL_VERSION;
+	fs << "ColorSpace" << (int) m_color_space;
+	fs << "Mean" << m_mean;
+	fs << "Variance" << m_variance;
+	fs.release();
+	return true;
+}
+
+/**
+ * Switch color space, this empties the model (learn or load it again)
+ * The brightness threshold (V or Y) is twice as wide (in deviations) as the
+ * color ones, for shadow removal
+ */
+void BackgroundModel::setColorSpace(
+		ColorSpace color_space)
+{
+	m_color_space = color_space;
+	if (m_color_space == YCRCB)
+	{
+		m_deviations = Vec3f(6, 3, 3);
+		m_min_thresholds = Vec3f(24, 8, 8);
+	}
+	else
+	{
+		m_deviations = Vec3f(3, 3, 6);
+		m_min_thresholds = Vec3f(8, 16, 24);
+	}
+
+	m_mean.release();
+	m_variance.release();
+}
+
+int BackgroundModel::getConversion() const
+{
+	return m_color_space == YCRCB ? CV_BGR2YCrCb : CV_BGR2HSV;
+}
+
+/**
+ * Mean as 8 bit H, S and V channel images (also for a YCrCb model)
+ */
+vector<Mat> BackgroundModel::getMeanChannels() const
+{
+	Mat mean8, hsv;
+	m_mean.convertTo(mean8, CV_8UC3);
+	if (m_color_space == YCRCB)
+	{
+		Mat bgr;
+		cvtColor(mean8, bgr, CV_YCrCb2BGR);
+		cvtColor(bgr, hsv, CV_BGR2HSV);
+	}
+	else
+	{
+		hsv = mean8;
+	}
+
+	vector<Mat> channels;
+	split(hsv, channels);
+
+	// A hue mean just under 180 rounds to 180, which is hue 0
+	if (m_color_space == HSV) channels[0].setTo(0, channels[0] >= 180);
+	return channels;
+}
+
+/**
+ * Shrink the model by an integer factor, for segmentation at a reduced
+ * resolution. Mean and variance are averaged over each block of pixels
+ * (the variance of a block's average is smaller, so the thresholds only
+ * get more tolerant). Hue means are averaged as angles.
+ */
+void BackgroundModel::downscale(
+		int factor)
+{
+	if (m_mean.empty() || factor <= 1) return;
+
+	const Size size(m_mean.cols / factor, m_mean.rows / factor);
+	if (m_color_space == HSV)
+	{
+		vector<Mat> channels;
+		split(m_mean, channels);
+
+		// Average the hues as unit vectors, hue 0..180 is angle 0..360 degrees
+		Mat hue_cos, hue_sin, magnitude;
+		polarToCart(Mat(), channels[0] * 2, hue_cos, hue_sin, true);
+		resize(hue_cos, hue_cos, size, 0, 0, INTER_AREA);
+		resize(hue_sin, hue_sin, size, 0, 0, INTER_AREA);
+		cartToPolar(hue_cos, hue_sin, magnitude, channels[0], true);
+		channels[0] *= 0.5;
+
+		for (size_t c = 1; c < channels.size(); ++c)
+			resize(channels[c], channels[c], size, 0, 0, INTER_AREA);
+		merge(channels, m_mean);
+	}
+	else
+	{
+		resize(m_mean, m_mean, size, 0, 0, INTER_AREA);
+	}
+	resize(m_variance, m_variance, size, 0, 0, INTER_AREA);
+}
+
+/**
+ * Segment (and with Adapt, learn from) the pixels first to last of a row
+ *
+ * A channel differs when its squared difference exceeds the squared threshold
+ * max(min threshold, deviations x standard deviation), so the thresholds
+ * follow the adapting variance without a square root. The mask bits are
+ * written 64 pixels at a time, only bits first to last are touched.
+ *
+ * The color space and adaptation are template parameters, so the loop
+ * carries no branches: the per channel decisions are combined with bitwise
+ * operators and the rate is simply multiplied by 0 for foreground pixels.
+ */
+template<bool Hsv, bool Adapt>
+static void subtractRow(
+		const uchar* pixel, float* mean, float* variance, uint64_t* out, int first, int last,
+		const Vec3f &min_sq, const Vec3f &deviations_sq, float rate)
+{
+	uint64_t word = 0;
+	for (int x = first; x <= last; ++x)
+	{
+		const int i = 3 * x;
+		const float d0 = Hsv ? hueDifference(pixel[i], mean[i]) : pixel[i] - mean[i];
+		const float d1 = pixel[i + 1] - mean[i + 1];
+		const float d2 = pixel[i + 2] - mean[i + 2];
+		const bool c0 = d0 * d0 > max(min_sq[0], deviations_sq[0] * variance[i]);
+		const bool c1 = d1 * d1 > max(min_sq[1], deviations_sq[1] * variance[i + 1]);
+		const bool c2 = d2 * d2 > max(min_sq[2], deviations_sq[2] * variance[i + 2]);
+		const bool changed = Hsv ? ((c0 & c1) | c2) : (c0 | c1 | c2);
+
+		word |= (uint64_t) changed << (x & 63);
+		if ((x & 63) == 63 || x == last)
+		{
+			const int from = max(first, x & ~63) & 63;
+			const uint64_t bits = (~(uint64_t) 0 >> (63 - (x & 63))) & (~(uint64_t) 0 << from);
+			out[x >> 6] = (out[x >> 6] & ~bits) | word;
+			word = 0;
+		}
+
+		if (!Adapt) continue;
+
+		// Running average of the background pixels
+		const float r = rate * !changed;
+		mean[i] += r * d0;
+		mean[i + 1] += r * d1;
+		mean[i + 2] += r * d2;
+		variance[i] += r * (d0 * d0 - variance[i]);
+		variance[i + 1] += r * (d1 * d1 - variance[i + 1]);
+		variance[i + 2] += r * (d2 * d2 - variance[i + 2]);
+
+		// The hue mean stays in [0, 180)
+		if (Hsv) mean[i] += 180.f * ((mean[i] < 0) - (mean[i] >= 180));
+	}
+}
+
+/**
+ * Foreground of an image in the model's color space, per pixel
+ * - HSV: (H and S differ) or V differs more than its threshold (hue alone
+ *   is unreliable at low saturation), hue differs the short way round
+ * - YCrCb: Cr, Cb or Y differs more than its threshold
+ * The mask is written 64 pixels per word.
+ *
+ * With a rate > 0 the background pixels are blended into the model in the
+ * same pass (running average of mean and variance), so the model follows
+ * slow lighting changes. See subtractRow(): the update is part of the
+ * segmentation loop, reusing its differences.
+ *
+ * Only the pixels of areas (e.g. the changed tiles, see ChangeDetector) are
+ * segmented, spans limits that further to the first to last pixel of every
+ * row (see Camera::getRoiSpans(), empty spans is the whole row). The mask
+ * bits of all other pixels are left as they are, pixels outside the areas
+ * are never read.
+ */
+void BackgroundModel::subtract(
+		const Mat &image, const vector<Vec2i> &spans, const vector<Rect> &areas, BitMask &foreground, float rate)
+{
+	assert(image.size() == m_mean.size() && image.type() == CV_8UC3);
+	assert(spans.empty() || (int) spans.size() == image.rows);
+	if (foreground.size() != image.size()) foreground.create(image.rows, image.cols);
+
+	typedef void (*Row)(const uchar*, float*, float*, uint64_t*, int, int, const Vec3f&, const Vec3f&, float);
+	const bool hsv = m_color_space == HSV;
+	const Row row = rate > 0 ? (hsv ? subtractRow<true, true> : subtractRow<false, true>)
+			: (hsv ? subtractRow<true, false> : subtractRow<false, false>);
+	const Vec3f min_sq = m_min_thresholds.mul(m_min_thresholds);
+	const Vec3f deviations_sq = m_deviations.mul(m_deviations);
+
+	for (size_t a = 0; a < areas.size(); ++a)
+	{
+		const Rect &area = areas[a];
+		for (int y = area.y; y < area.y + area.height; ++y)
+		{
+			int first = area.x, last = area.x + area.width - 1;
+			if (!spans.empty())
+			{
+				first = max(first, spans[y][0]);
+				last = min(last, spans[y][1]);
+			}
+			if (first > last) continue;
+
+			row(image.ptr<uchar>(y), m_mean.ptr<float>(y), m_variance.ptr<float>(y), foreground.row(y), first, last,
+					min_sq, deviations_sq, rate);
+		}
+	}
+}
+
+} /* namespace nl_uu_science_gmt */
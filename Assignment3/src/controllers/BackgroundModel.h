@@ -0,0 +1,120 @@
+/*
+ * BackgroundModel.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef BACKGROUNDMODEL_H_
+#define BACKGROUNDMODEL_H_
+
+#include <opencv2/core/core.hpp>
+#include <string>
+#include <vector>
+
+#include "../utilities/BitMask.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Per pixel background model in HSV (or YCrCb): the mean and variance of
+ * every pixel over the frames of the camera's background video. A pixel is
+ * foreground when it differs more than a few of its own standard deviations
+ * from the mean, so flickering or noisy areas get a wide threshold and steady
+ * areas a tight one, instead of one threshold for the whole image.
+ * Optionally the model keeps learning from the background pixels of the
+ * frames it segments (see subtract()).
+ */
+class BackgroundModel
+{
+public:
+	enum ColorSpace
+	{
+		HSV, YCRCB
+	};
+
+private:
+	ColorSpace m_color_space;               // Space the model and the segmented images are in
+	cv::Mat m_mean;                         // Mean color per pixel (CV_32FC3)
+	cv::Mat m_variance;                     // Variance per pixel and channel (CV_32FC3)
+
+	cv::Vec3f m_deviations;                 // Threshold per channel in standard deviations
+	cv::Vec3f m_min_thresholds;             // Lowest threshold per channel (also for pixels that never changed)
+
+public:
+	BackgroundModel(
+			ColorSpace = HSV);
+	virtual ~BackgroundModel();
+
+	bool learn(
+			const std::string &, int = 100);
+	bool load(
+			const std::string &);
+	bool save(
+			const std::string &) const;
+	void downscale(
+			int);
+	void setColorSpace(
+			ColorSpace);
+	std::vector<cv::Mat> getMeanChannels() const;
+
+	void subtract(
+			const cv::Mat &, const std::vector<cv::Vec2i> &, const std::vector<cv::Rect> &, BitMask &, float = 0);
+
+	bool empty() const
+	{
+		return m_mean.empty();
+	}
+
+	const cv::Size getSize() const
+	{
+		return m_mean.size();
+	}
+
+	const cv::Mat& getMean() const
+	{
+		return m_mean;
+	}
+
+	const cv::Mat& getVariance() const
+	{
+		return m_variance;
+	}
+
+	ColorSpace getColorSpace() const
+	{
+		return m_color_space;
+	}
+
+	/**
+	 * cvtColor code from BGR to the model's color space
+	 */
+	int getConversion() const;
+
+	const cv::Vec3f& getDeviations() const
+	{
+		return m_deviations;
+	}
+
+	void setDeviations(
+			const cv::Vec3f &deviations)
+	{
+		m_deviations = deviations;
+	}
+
+	const cv::Vec3f& getMinThresholds() const
+	{
+		return m_min_thresholds;
+	}
+
+	void setMinThresholds(
+			const cv::Vec3f &minThresholds)
+	{
+		m_min_thresholds = minThresholds;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* BACKGROUNDMODEL_H_ */
@@ -45,6 +45,9 @@ Camera::Camera(
 	m_cx = 0;
 	m_cy = 0;
 	m_frame_amount = 0;
+	m_position = 0;
+	m_use_raw_video = false;
+	m_mask_scale = 1;
 }
 
 Camera::~Camera()
@@ -58,8 +61,29 @@ bool Camera::initialize()
 {
 	m_initialized = true;
 
+	// Prefer a per pixel model of the background video, learned once and cached
+	if (General::fexists(m_data_path + General::BackgroundVideoFile))
+	{
+		if (!m_background_model.load(m_data_path + General::BackgroundModelFile))
+		{
+			cout << "Learning background model: " << m_data_path + General::BackgroundVideoFile << endl;
+			if (!m_background_model.learn(m_data_path + General::BackgroundVideoFile))
+			{
+				return false;
+			}
+			if (!m_background_model.save(m_data_path + General::BackgroundModelFile))
+			{
+				cerr << "Unable to write: " << m_data_path + General::BackgroundModelFile << endl;
+			}
+		}
+	}
+
 	Mat bg_image;
-	if (General::fexists(m_data_path + General::BackgroundImageFile))
+	if (!m_background_model.empty())
+	{
+		m_bg_hsv_channels = m_background_model.getMeanChannels();
+	}
+	else if (General::fexists(m_data_path + General::BackgroundImageFile))
 	{
 		bg_image = imread(m_data_path + General::BackgroundImageFile);
 		if (bg_image.empty())
@@ -73,12 +97,16 @@ bool Camera::initialize()
 		cout << "Unable to find background image: " << m_data_path + General::BackgroundImageFile;
 		return false;
 	}
-	assert(!bg_image.empty());
 
-	// Disect the background image in HSV-color space
-	Mat bg_hsv_im;
-	cvtColor(bg_image, bg_hsv_im, CV_BGR2HSV);
-	split(bg_hsv_im, m_bg_hsv_channels);
+	if (m_bg_hsv_channels.empty())
+	{
+		assert(!bg_image.empty());
+
+		// Disect the background image in HSV-color space
+		Mat bg_hsv_im;
+		cvtColor(bg_image, bg_hsv_im, CV_BGR2HSV);
+		split(bg_hsv_im, m_bg_hsv_channels);
+	}
 
 	// Open the video for this camera
 	m_video = VideoCapture(m_data_path + General::VideoFile);
@@ -88,15 +116,37 @@ bool Camera::initialize()
 	m_plane_size.width = (int) m_video.get(CAP_PROP_FRAME_WIDTH);
 	m_plane_size.height = (int) m_video.get(CAP_PROP_FRAME_HEIGHT);
 	assert(m_plane_size.area() > 0);
+	assert(m_background_model.empty() || m_background_model.getSize() == m_plane_size);
 
-	// Get the amount of video frames
-	m_video.set(CAP_PROP_POS_AVI_RATIO, 1);  // Go to the end of the video; 1 = 100%
-	m_frame_amount = (long) m_video.get(CAP_PROP_POS_FRAMES);
+	if (m_use_raw_video)
+	{
+		// Read the frames from the raw video file, transcoded once (and again when the video changed)
+		const long long video_size = General::fsize(m_data_path + General::VideoFile);
+		if (!m_raw_video.open(m_data_path + General::RawVideoFile, video_size))
+		{
+			cout << "Transcoding video: " << m_data_path + General::VideoFile << endl;
+			if (!RawVideo::transcode(m_data_path + General::VideoFile, m_data_path + General::RawVideoFile)
+					|| !m_raw_video.open(m_data_path + General::RawVideoFile, video_size))
+			{
+				cerr << "Unable to read: " << m_data_path + General::RawVideoFile << endl;
+				return false;
+			}
+		}
+		assert(m_raw_video.getFrameSize() == m_plane_size);
+		m_frame_amount = m_raw_video.getFrames();
+	}
+	else
+	{
+		// Get the amount of video frames (and the keyframes, for seeking) from the index, built once and cached
+		if (!m_video_index.open(m_data_path + General::VideoFile, m_data_path + General::VideoIndexFile))
+		{
+			cerr << "Unable to index: " << m_data_path + General::VideoFile << endl;
+			return false;
+		}
+		m_frame_amount = m_video_index.getFrames();
+	}
 	assert(m_frame_amount > 1);
-	m_video.set(CAP_PROP_POS_AVI_RATIO, 0);  // Go back to the start
-
-	m_video.release(); //Re-open the file because _video.set(CAP_PROP_POS_AVI_RATIO, 1) may screw it up
-	m_video = cv::VideoCapture(m_data_path + General::VideoFile);
+	m_position = 0;
 
 	// Read the camera properties (XML)
 	FileStorage fs;
@@ -141,32 +191,87 @@ bool Camera::initialize()
 }
 
 /**
- * Set and return the next frame from the video
+ * Get the given frame of the video into the given image
+ * A raw video frame is the mapped pixels in place.
+ * Otherwise recently read frames come from the frame cache, the others are
+ * decoded (and cached, so the image gets its own pixels).
  */
-Mat& Camera::advanceVideoFrame()
+bool Camera::readVideoFrame(
+		int frame_number, Mat &frame)
 {
-	m_video >> m_frame;
-	assert(!m_frame.empty());
-	return m_frame;
+	if (m_raw_video.isOpened())
+	{
+		frame = m_raw_video.getFrame(frame_number);
+		return !frame.empty();
+	}
+
+	if (m_frame_cache.getImage(frame_number, frame)) return true;
+
+	frame.release();
+	if (!setVideoFrame(frame_number) || !m_video.read(frame))
+	{
+		// Wherever the reader stopped, the next frame has to seek
+		m_position = -1;
+		return false;
+	}
+	++m_position;
+
+	m_frame_cache.putImage(frame_number, frame);
+	return true;
 }
 
 /**
- * Set the video location to the given frame number
+ * Segment the frames at 1 / scale of their size, the background is scaled
+ * down once here (call before any segmentation)
  */
-void Camera::setVideoFrame(
-		int frame_number)
+void Camera::setMaskScale(
+		int scale)
 {
-	m_video.set(CAP_PROP_POS_FRAMES, frame_number);
+	assert(m_mask_scale == 1 && scale >= 1);
+	if (scale == 1) return;
+	m_mask_scale = scale;
+
+	m_background_model.downscale(scale);
+	for (size_t i = 0; i < m_bg_hsv_channels.size(); ++i)
+		resize(m_bg_hsv_channels[i], m_bg_hsv_channels[i], getMaskSize(), 0, 0, INTER_AREA);
 }
 
 /**
- * Set and return frame of the video location at the given frame number
+ * Set the video location to the given frame number
+ * A seek makes the video reader decode from the last keyframe before the
+ * frame, so when the current position is ahead of that keyframe (and before
+ * the frame) the frames in between are just grabbed from here instead. The
+ * seek itself goes to the keyframe, where decoding starts anyway.
+ * A raw video has no decoding to do, any frame is right there.
+ * Returns false if the video ended before the frame, the position is
+ * unknown then (the next call seeks)
  */
-Mat& Camera::getVideoFrame(
+bool Camera::setVideoFrame(
 		int frame_number)
 {
-	setVideoFrame(frame_number);
-	return advanceVideoFrame();
+	if (frame_number == m_position) return true;
+	if (m_raw_video.isOpened())
+	{
+		m_position = frame_number;
+		return true;
+	}
+
+	const int keyframe = m_video_index.keyframeBefore(frame_number);
+	if (frame_number < m_position || keyframe > m_position)
+	{
+		m_video.set(CAP_PROP_POS_FRAMES, keyframe);
+		m_position = keyframe;
+	}
+	while (m_position < frame_number)
+	{
+		if (!m_video.grab())
+		{
+			m_position = -1;
+			return false;
+		}
+		++m_position;
+	}
+	return true;
 }
 
 float distance(Point point1, Point point2)
@@ -14,6 +14,12 @@
 #include <string>
 #include <vector>
 
+#include "BackgroundModel.h"
+#include "ChangeDetector.h"
+#include "FrameCache.h"
+#include "RawVideo.h"
+#include "VideoIndex.h"
+
 namespace nl_uu_science_gmt
 {
 
@@ -30,9 +36,17 @@ class Camera
 	const int m_id;                                 // Camera ID
 
 	std::vector<cv::Mat> m_bg_hsv_channels;          // Background HSV channel images
-	cv::Mat m_foreground_image;                      // This camera's foreground image (binary)
+	BackgroundModel m_background_model;              // Per pixel background model (empty without background video)
+	ChangeDetector m_change_detector;                // Tiles of the frame that changed since they were segmented
+	std::vector<cv::Vec2i> m_roi_spans;              // Per row, first and last mask pixel carving can depend on (first > last: none)
+	int m_mask_scale;                                // Frames are segmented at 1 / m_mask_scale of their size
 
 	cv::VideoCapture m_video;                        // Video reader
+	VideoIndex m_video_index;                        // Frame count and keyframes of the video
+	int m_position;                                  // Frame the video reader returns next (-1: unknown, seek first)
+	FrameCache m_frame_cache;                        // Recently decoded frames and their foreground masks
+	bool m_use_raw_video;                            // Read the frames from a raw video file instead of decoding them
+	RawVideo m_raw_video;                            // Memory mapped decoded frames (open if m_use_raw_video)
 
 	cv::Size m_plane_size;                           // Camera's FoV size
 	long m_frame_amount;                             // Amount of frames in this camera's video
@@ -51,8 +65,6 @@ class Camera
 	std::vector<cv::Point3f> m_camera_plane;         // Camera plane of view
 	std::vector<cv::Point3f> m_camera_floor;         // Projection of the camera itself onto the ground floor view
 
-	cv::Mat m_frame;                                 // Current video frame (image)
-
 	static void onMouse(int, int, int, int, void*);
 	void initCamLoc();
 	inline void camPtInWorld();
@@ -66,9 +78,9 @@ public:
 
 	bool initialize();
 
-	cv::Mat& advanceVideoFrame();
-	cv::Mat& getVideoFrame(int);
-	void setVideoFrame(int);
+	bool readVideoFrame(int, cv::Mat &);
+	void setMaskScale(int);
+	bool setVideoFrame(int);
 
 	static bool detExtrinsics(const std::string &, const std::string &, const std::string &, const std::string &);
 
@@ -105,11 +117,50 @@ public:
 		return m_frame_amount;
 	}
 
+	const VideoIndex& getVideoIndex() const
+	{
+		return m_video_index;
+	}
+
 	const std::vector<cv::Mat>& getBgHsvChannels() const
 	{
 		return m_bg_hsv_channels;
 	}
 
+	const BackgroundModel& getBackgroundModel() const
+	{
+		return m_background_model;
+	}
+
+	BackgroundModel& getBackgroundModel()
+	{
+		return m_background_model;
+	}
+
+	ChangeDetector& getChangeDetector()
+	{
+		return m_change_detector;
+	}
+
+	FrameCache& getFrameCache()
+	{
+		return m_frame_cache;
+	}
+
+	bool isUseRawVideo() const
+	{
+		return m_use_raw_video;
+	}
+
+	/**
+	 * Takes effect at initialize()
+	 */
+	void setUseRawVideo(
+			bool useRawVideo)
+	{
+		m_use_raw_video = useRawVideo;
+	}
+
 	bool isInitialized() const
 	{
 		return m_initialized;
@@ -120,19 +171,27 @@ public:
 		return m_plane_size;
 	}
 
-	const cv::Mat& getForegroundImage() const
+	int getMaskScale() const
+	{
+		return m_mask_scale;
+	}
+
+	/**
+	 * Size of the foreground masks (and the background model), the frame size / m_mask_scale
+	 */
+	const cv::Size getMaskSize() const
 	{
-		return m_foreground_image;
+		return cv::Size(m_plane_size.width / m_mask_scale, m_plane_size.height / m_mask_scale);
 	}
 
-	void setForegroundImage(const cv::Mat& foregroundImage)
+	const std::vector<cv::Vec2i>& getRoiSpans() const
 	{
-		m_foreground_image = foregroundImage;
+		return m_roi_spans;
 	}
 
-	const cv::Mat& getFrame() const
+	void setRoiSpans(const std::vector<cv::Vec2i>& roiSpans)
 	{
-		return m_frame;
+		m_roi_spans = roiSpans;
 	}
 
 	const std::vector<cv::Point3f>& getCameraFloor() const
@@ -0,0 +1,122 @@
+/*
+ * ChangeDetector.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "ChangeDetector.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+ChangeDetector::ChangeDetector(
+		int tile_width, int tile_height, int sampling, int mean_threshold, int pixel_threshold, int refresh_interval) :
+				m_tile_width(tile_width),
+				m_tile_height(tile_height),
+				m_sampling(sampling),
+				m_mean_threshold(mean_threshold),
+				m_pixel_threshold(pixel_threshold),
+				m_refresh_interval(refresh_interval),
+				m_frame(0)
+{
+}
+
+ChangeDetector::~ChangeDetector()
+{
+}
+
+/**
+ * Compare the sampled pixels of an area with the reference
+ */
+bool ChangeDetector::changed(
+		const Mat &image, const Rect &area) const
+{
+	int sum = 0, samples = 0;
+	for (int y = area.y; y < area.y + area.height; y += m_sampling)
+	{
+		const uchar* pixel = image.ptr<uchar>(y);
+		const uchar* reference = m_reference.ptr<uchar>(y);
+		for (int x = area.x; x < area.x + area.width; x += m_sampling)
+		{
+			const int i = 3 * x;
+			const int difference = abs(pixel[i] - reference[i]) + abs(pixel[i + 1] - reference[i + 1]) + abs(pixel[i + 2] - reference[i + 2]);
+			if (difference > m_pixel_threshold) return true;
+			sum += difference;
+			samples++;
+		}
+	}
+	return sum > m_mean_threshold * samples;
+}
+
+/**
+ * Find the changed tiles of image (BGR), only tiles that overlap the spans
+ * (see Camera::getRoiSpans(), empty is the whole image) count. The changed
+ * tiles, clipped to the spans, are in getChanged() and the unchanged tiles
+ * whose turn it is to be refreshed in getRefreshed(), both become the
+ * reference. After a size change (or reset()) everything has changed.
+ * Returns the fraction of the tiles that isn't segmented.
+ */
+float ChangeDetector::detect(
+		const Mat &image, const vector<Vec2i> &spans)
+{
+	assert(image.type() == CV_8UC3);
+	assert(spans.empty() || (int) spans.size() == image.rows);
+
+	const bool fresh = m_reference.size() != image.size();
+	if (fresh)
+	{
+		m_reference.create(image.size(), CV_8UC3);
+		m_mask.create(image.rows, image.cols);
+	}
+
+	m_changed.clear();
+	m_refreshed.clear();
+	m_frame++;
+	int tiles = 0;
+	for (int ty = 0; ty < image.rows; ty += m_tile_height)
+	{
+		const int height = min(m_tile_height, image.rows - ty);
+		for (int tx = 0; tx < image.cols; tx += m_tile_width)
+		{
+			Rect area(tx, ty, min(m_tile_width, image.cols - tx), height);
+			if (!spans.empty())
+			{
+				int first = INT_MAX, last = -1;
+				for (int y = ty; y < ty + height; ++y)
+				{
+					first = min(first, max(spans[y][0], area.x));
+					last = max(last, min(spans[y][1], area.x + area.width - 1));
+				}
+				if (first > last) continue;
+				area.x = first;
+				area.width = last - first + 1;
+			}
+
+			tiles++;
+			const bool refresh = m_refresh_interval > 0 && (m_frame + tiles) % m_refresh_interval == 0;
+			if (fresh || changed(image, area))
+				m_changed.push_back(area);
+			else if (refresh)
+				m_refreshed.push_back(area);
+			else
+				continue;
+
+			Mat reference = m_reference(area);
+			image(area).copyTo(reference);
+		}
+	}
+
+	const int segmented = (int) (m_changed.size() + m_refreshed.size());
+	return tiles > 0 ? (float) (tiles - segmented) / tiles : 0.f;
+}
+
+} /* namespace nl_uu_science_gmt */
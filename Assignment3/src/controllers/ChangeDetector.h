@@ -0,0 +1,125 @@
+/*
+ * ChangeDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef CHANGEDETECTOR_H_
+#define CHANGEDETECTOR_H_
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+#include "../utilities/BitMask.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Finds the tiles of a camera's frame that changed since they were last
+ * segmented, so only those are segmented again and the others keep their
+ * mask. A tile changed when the sum of absolute differences over a sparse
+ * grid of its pixels is too large on average, or a single sampled pixel
+ * differs a lot (a small object entering).
+ *
+ * Every tile is compared with the image it was last segmented from, not with
+ * the previous frame, so slow changes add up until the tile is redone.
+ * Only the part of a tile within the region of interest is compared.
+ *
+ * Lighting drifts too slowly to ever change a tile, yet the background models
+ * have to follow it (see BackgroundModel::subtract()). So every frame a
+ * rotating 1 / m_refresh_interval of the unchanged tiles is refreshed:
+ * segmented again as if it changed, every tile once per interval.
+ */
+class ChangeDetector
+{
+	int m_tile_width;                       // Pixels (a multiple of 64 keeps a tile's mask bits in whole words)
+	int m_tile_height;                      // Pixels
+	int m_sampling;                         // Every m_sampling-th pixel of every m_sampling-th row is compared
+	int m_mean_threshold;                   // Mean absolute difference (sum over the channels) of a changed tile
+	int m_pixel_threshold;                  // Absolute difference (sum over the channels) of a changed pixel
+	int m_refresh_interval;                 // Frames between the refreshes of an unchanged tile (0: never)
+	unsigned m_frame;                       // Frames detected, rotates the refreshed tiles
+
+	cv::Mat m_reference;                    // Every tile as it was last segmented (BGR)
+	BitMask m_mask;                         // Raw foreground mask of the last segmentation of every tile
+	std::vector<BitMask::Scratch> m_scratch;  // Morphology working memory per band of the mask
+	std::vector<cv::Rect> m_changed;        // Changed tiles to segment in the current frame
+	std::vector<cv::Rect> m_refreshed;      // Unchanged tiles to segment in the current frame
+
+	bool changed(
+			const cv::Mat &, const cv::Rect &) const;
+
+public:
+	ChangeDetector(
+			int = 64, int = 16, int = 4, int = 6, int = 60, int = 16);
+	virtual ~ChangeDetector();
+
+	float detect(
+			const cv::Mat &, const std::vector<cv::Vec2i> &);
+
+	void reset()
+	{
+		m_reference.release();
+	}
+
+	int getTileHeight() const
+	{
+		return m_tile_height;
+	}
+
+	const std::vector<cv::Rect>& getChanged() const
+	{
+		return m_changed;
+	}
+
+	const std::vector<cv::Rect>& getRefreshed() const
+	{
+		return m_refreshed;
+	}
+
+	int getRefreshInterval() const
+	{
+		return m_refresh_interval;
+	}
+
+	BitMask& getMask()
+	{
+		return m_mask;
+	}
+
+	/**
+	 * Working memory for cleaning the mask, one per band (see Scene3DRenderer::processForegrounds())
+	 */
+	std::vector<BitMask::Scratch>& getScratch()
+	{
+		return m_scratch;
+	}
+
+	int getMeanThreshold() const
+	{
+		return m_mean_threshold;
+	}
+
+	void setMeanThreshold(
+			int meanThreshold)
+	{
+		m_mean_threshold = meanThreshold;
+	}
+
+	int getPixelThreshold() const
+	{
+		return m_pixel_threshold;
+	}
+
+	void setPixelThreshold(
+			int pixelThreshold)
+	{
+		m_pixel_threshold = pixelThreshold;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* CHANGEDETECTOR_H_ */
@@ -0,0 +1,281 @@
+/*
+ * Clusterer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "Clusterer.h"
+
+#include <opencv2/core/core.hpp>
+#include <cfloat>
+#include <iostream>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Constructor
+ * k clusters, the amount of Lloyd iterations per tracked frame, the cost
+ * increase (factor) at which the clustering is started over and the amount
+ * of k-means++ seedings tried when it is
+ */
+Clusterer::Clusterer(
+		int k, int iterations, double reseed_ratio, int attempts) :
+				m_k(k),
+				m_iterations(iterations),
+				m_reseed_ratio(reseed_ratio),
+				m_attempts(attempts),
+				m_rng(0x1234),
+				m_cost(0)
+{
+}
+
+Clusterer::~Clusterer()
+{
+}
+
+/**
+ * Label the voxels with the cluster they belong to
+ * floor holds the amount of voxels per floor grid column (see Reconstructor::carve)
+ * Returns false (and no labels) if there are fewer voxel columns than clusters
+ */
+bool Clusterer::cluster(
+		const vector<Reconstructor::Voxel*> &voxels, const vector<int> &floor, vector<int> &labels)
+{
+	labels.clear();
+
+	// One weighted point per occupied column
+	vector<int> point_of_column(floor.size(), -1);
+	vector<Point2f> points;
+	vector<float> weights;
+	for (size_t i = 0; i < voxels.size(); i++)
+	{
+		const int column = voxels[i]->column;
+		if (point_of_column[column] >= 0) continue;
+
+		point_of_column[column] = (int) points.size();
+		points.push_back(Point2f((float) voxels[i]->x, (float) voxels[i]->y));
+		weights.push_back((float) floor[column]);
+	}
+
+	if ((int) points.size() < m_k)
+	{
+		reset();
+		return false;
+	}
+
+	vector<int> column_labels;
+	bool warm = false;
+	if ((int) m_centers.size() == m_k)
+	{
+		// Tracking: start from where the people were in the previous frame,
+		// on a copy so a rejected start leaves those for seed() to match
+		vector<Point2f> centers = m_centers;
+		bool filled = true;
+		for (int i = 0; i < m_iterations && filled; ++i)
+		{
+			assign(points, weights, centers, column_labels);
+			filled = update(points, weights, column_labels, centers);
+		}
+
+		if (filled)
+		{
+			const double cost = assign(points, weights, centers, column_labels);
+			if (m_cost <= 0 || cost <= m_cost * m_reseed_ratio)
+			{
+				m_centers = centers;
+				m_cost = cost;
+				warm = true;
+			}
+		}
+		// The cost jumped or a cluster lost all its voxels: start over
+	}
+
+	if (!warm) seed(points, weights, column_labels);
+
+	// Every voxel gets the label of its column
+	labels.resize(voxels.size());
+	for (size_t i = 0; i < voxels.size(); i++)
+		labels[i] = column_labels[point_of_column[voxels[i]->column]];
+
+	return true;
+}
+
+/**
+ * Assign every point to its nearest center
+ * Returns the weighted mean squared distance of the points to their centers
+ */
+double Clusterer::assign(
+		const vector<Point2f> &points, const vector<float> &weights, const vector<Point2f> &centers,
+		vector<int> &labels) const
+{
+	labels.resize(points.size());
+	double cost = 0, weight = 0;
+
+	int i;
+#pragma omp parallel for schedule(static) private(i) reduction(+:cost,weight)
+	for (i = 0; i < (int) points.size(); ++i)
+	{
+		float best_distance = FLT_MAX;
+		int best = 0;
+		for (int j = 0; j < m_k; ++j)
+		{
+			const float dx = points[i].x - centers[j].x;
+			const float dy = points[i].y - centers[j].y;
+			const float distance = dx * dx + dy * dy;
+			if (distance < best_distance)
+			{
+				best_distance = distance;
+				best = j;
+			}
+		}
+		labels[i] = best;
+		cost += weights[i] * best_distance;
+		weight += weights[i];
+	}
+
+	return weight > 0 ? cost / weight : 0;
+}
+
+/**
+ * Move every center to the weighted mean of its points
+ * Returns false if a center has no points left
+ */
+bool Clusterer::update(
+		const vector<Point2f> &points, const vector<float> &weights, const vector<int> &labels,
+		vector<Point2f> &centers) const
+{
+	vector<double> sum_x(m_k, 0), sum_y(m_k, 0), sum_w(m_k, 0);
+
+	// A few hundred columns at most, not worth the threads
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		sum_x[labels[i]] += weights[i] * points[i].x;
+		sum_y[labels[i]] += weights[i] * points[i].y;
+		sum_w[labels[i]] += weights[i];
+	}
+
+	for (int j = 0; j < m_k; ++j)
+	{
+		if (sum_w[j] <= 0) return false;
+		centers[j] = Point2f((float) (sum_x[j] / sum_w[j]), (float) (sum_y[j] / sum_w[j]));
+	}
+	return true;
+}
+
+/**
+ * Weighted k-means++ initial centers: every next center is drawn with a
+ * probability proportional to weight * squared distance to the nearest center
+ */
+void Clusterer::plusplus(
+		const vector<Point2f> &points, const vector<float> &weights, vector<Point2f> &centers)
+{
+	centers.resize(m_k);
+	vector<double> distances(points.size(), DBL_MAX);
+
+	double total = 0;
+	for (size_t i = 0; i < weights.size(); ++i)
+		total += weights[i];
+
+	int pick = 0;
+	double target = m_rng.uniform(0., total);
+	while (pick < (int) points.size() - 1 && (target -= weights[pick]) > 0)
+		++pick;
+	centers[0] = points[pick];
+
+	for (int j = 1; j < m_k; ++j)
+	{
+		total = 0;
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			const double dx = points[i].x - centers[j - 1].x;
+			const double dy = points[i].y - centers[j - 1].y;
+			distances[i] = min(distances[i], dx * dx + dy * dy);
+			total += weights[i] * distances[i];
+		}
+
+		pick = 0;
+		target = m_rng.uniform(0., total);
+		while (pick < (int) points.size() - 1 && (target -= weights[pick] * distances[pick]) > 0)
+			++pick;
+		centers[j] = points[pick];
+	}
+}
+
+/**
+ * Cluster from scratch with weighted k-means++, best of m_attempts
+ * Clusters keep the number of the nearest previous center where possible
+ */
+bool Clusterer::seed(
+		const vector<Point2f> &points, const vector<float> &weights, vector<int> &labels)
+{
+	const int max_iterations = 10;
+
+	vector<Point2f> seeded;
+	double best_cost = DBL_MAX;
+	vector<Point2f> centers;
+	vector<int> attempt_labels;
+	for (int a = 0; a < max(m_attempts, 1); ++a)
+	{
+		plusplus(points, weights, centers);
+
+		bool filled = true;
+		for (int i = 0; i < max_iterations && filled; ++i)
+		{
+			assign(points, weights, centers, attempt_labels);
+			filled = update(points, weights, attempt_labels, centers);
+		}
+		if (!filled) continue;
+
+		const double cost = assign(points, weights, centers, attempt_labels);
+		if (cost < best_cost)
+		{
+			best_cost = cost;
+			seeded = centers;
+		}
+	}
+	// Every attempt emptied a cluster (duplicate columns are impossible, so this is rare): keep the last seeding
+	if (seeded.empty()) seeded = centers;
+
+	if ((int) m_centers.size() == m_k)
+	{
+		// Greedily pair the closest previous and new centers
+		vector<Point2f> ordered(m_k);
+		vector<bool> used_old(m_k, false), used_new(m_k, false);
+		for (int pair = 0; pair < m_k; ++pair)
+		{
+			float best_distance = FLT_MAX;
+			int best_old = 0, best_new = 0;
+			for (int o = 0; o < m_k; ++o)
+			{
+				if (used_old[o]) continue;
+				for (int n = 0; n < m_k; ++n)
+				{
+					if (used_new[n]) continue;
+					const float dx = m_centers[o].x - seeded[n].x;
+					const float dy = m_centers[o].y - seeded[n].y;
+					if (dx * dx + dy * dy < best_distance)
+					{
+						best_distance = dx * dx + dy * dy;
+						best_old = o;
+						best_new = n;
+					}
+				}
+			}
+			used_old[best_old] = used_new[best_new] = true;
+			ordered[best_old] = seeded[best_new];
+		}
+		seeded = ordered;
+	}
+
+	// Labels by nearest center, so no voxel ends up closer to another center than its own
+	m_centers = seeded;
+	m_cost = assign(points, weights, m_centers, labels);
+	return true;
+}
+
+} /* namespace nl_uu_science_gmt */
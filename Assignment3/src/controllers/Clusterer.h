@@ -0,0 +1,115 @@
+/*
+ * Clusterer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef CLUSTERER_H_
+#define CLUSTERER_H_
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+#include "Reconstructor.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * k-means of the visible voxels on the floor plane (x, y), with memory.
+ * Voxels in the same floor grid column share their (x, y), so the columns are
+ * clustered instead, weighted with their voxel count. Same result, but only
+ * a few hundred points instead of thousands of voxels.
+ * The first frame (or a frame where the people moved too much) is clustered
+ * from scratch with k-means++, the following frames start from the previous
+ * frame's centers and only run a few Lloyd iterations. That is much cheaper
+ * and keeps cluster i on the same person from frame to frame.
+ */
+class Clusterer
+{
+	const int m_k;                          // Amount of clusters
+	int m_iterations;                       // Lloyd iterations of a warm started frame
+	double m_reseed_ratio;                  // Re-seed when the cost grows more than this factor
+
+	int m_attempts;                         // k-means++ seedings per re-seed, the cheapest one wins
+	cv::RNG m_rng;                          // Random generator of the k-means++ seeding
+
+	std::vector<cv::Point2f> m_centers;     // Centers of the previous frame (empty: not seeded)
+	double m_cost;                          // Mean squared voxel to center distance of the previous frame
+
+	double assign(
+			const std::vector<cv::Point2f> &, const std::vector<float> &, const std::vector<cv::Point2f> &,
+			std::vector<int> &) const;
+	bool update(
+			const std::vector<cv::Point2f> &, const std::vector<float> &, const std::vector<int> &,
+			std::vector<cv::Point2f> &) const;
+	void plusplus(
+			const std::vector<cv::Point2f> &, const std::vector<float> &, std::vector<cv::Point2f> &);
+	bool seed(
+			const std::vector<cv::Point2f> &, const std::vector<float> &, std::vector<int> &);
+
+public:
+	Clusterer(
+			int, int = 3, double = 1.5, int = 5);
+	virtual ~Clusterer();
+
+	bool cluster(
+			const std::vector<Reconstructor::Voxel*> &, const std::vector<int> &, std::vector<int> &);
+
+	/**
+	 * Forget the previous centers, the next frame is seeded from scratch
+	 */
+	void reset()
+	{
+		m_centers.clear();
+		m_cost = 0;
+	}
+
+	const std::vector<cv::Point2f>& getCenters() const
+	{
+		return m_centers;
+	}
+
+	int getK() const
+	{
+		return m_k;
+	}
+
+	int getIterations() const
+	{
+		return m_iterations;
+	}
+
+	void setIterations(
+			int iterations)
+	{
+		m_iterations = iterations;
+	}
+
+	int getAttempts() const
+	{
+		return m_attempts;
+	}
+
+	void setAttempts(
+			int attempts)
+	{
+		m_attempts = attempts;
+	}
+
+	double getReseedRatio() const
+	{
+		return m_reseed_ratio;
+	}
+
+	void setReseedRatio(
+			double reseedRatio)
+	{
+		m_reseed_ratio = reseedRatio;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* CLUSTERER_H_ */
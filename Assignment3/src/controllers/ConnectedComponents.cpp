@@ -0,0 +1,222 @@
+/*
+ * ConnectedComponents.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "ConnectedComponents.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Constructor
+ * connectivity: 6 or 26, min_size: smallest component (in voxels) that is kept
+ */
+ConnectedComponents::ConnectedComponents(
+		const Reconstructor &r, int connectivity, int min_size) :
+				m_reconstructor(r),
+				m_connectivity(connectivity == 6 ? 6 : 26),
+				m_min_size(min_size)
+{
+	m_slot.assign(m_reconstructor.getVoxels().size(), -1);
+}
+
+ConnectedComponents::~ConnectedComponents()
+{
+}
+
+/**
+ * Root of the set v is in, with path halving
+ */
+int ConnectedComponents::find(
+		int v)
+{
+	while (m_parent[v] != v)
+	{
+		m_parent[v] = m_parent[m_parent[v]];
+		v = m_parent[v];
+	}
+	return v;
+}
+
+/**
+ * Merge the sets of a and b, the lowest index becomes the root
+ * so a set's root always lies in the lowest slab of the set
+ */
+void ConnectedComponents::unite(
+		int a, int b)
+{
+	a = find(a);
+	b = find(b);
+	if (a < b)
+		m_parent[b] = a;
+	else if (b < a)
+		m_parent[a] = b;
+}
+
+/**
+ * The neighbour offsets that were already visited in a scan over
+ * x, then y, then z (half of the neighbourhood)
+ */
+void ConnectedComponents::neighbours(
+		vector<Point3i> &offsets) const
+{
+	offsets.clear();
+	if (m_connectivity == 6)
+	{
+		offsets.push_back(Point3i(-1, 0, 0));
+		offsets.push_back(Point3i(0, -1, 0));
+		offsets.push_back(Point3i(0, 0, -1));
+		return;
+	}
+
+	for (int dz = -1; dz <= 0; ++dz)
+		for (int dy = -1; dy <= 1; ++dy)
+			for (int dx = -1; dx <= 1; ++dx)
+				if (dz < 0 || dy < 0 || (dy == 0 && dx < 0)) offsets.push_back(Point3i(dx, dy, dz));
+}
+
+/**
+ * Label the voxels with their connected component and drop the components
+ * smaller than the minimum size
+ *
+ * voxels: visible voxels, small components are removed (the order changes)
+ * floor: visible voxel count per floor grid column, the removed voxels are subtracted
+ * ids: receives the component per remaining voxel
+ * components: receives the size and bounding box of every remaining component
+ */
+void ConnectedComponents::label(
+		vector<Reconstructor::Voxel*> &voxels, vector<int> &floor, vector<int> &ids, vector<Component> &components)
+{
+	ids.clear();
+	components.clear();
+	if (voxels.empty()) return;
+
+	const int width = m_reconstructor.getFloorSize().width;
+	const int height = m_reconstructor.getFloorSize().height;
+	const int area = width * height;
+	const int layers = (int) m_reconstructor.getVoxels().size() / area;
+	const int slab_layers = 8;                               // Floor layers per parallel slab
+	const int slabs = (layers + slab_layers - 1) / slab_layers;
+
+	// Sort the voxels by floor layer (counting sort), so every slab is a consecutive range
+	vector<int> layer_start(layers + 1, 0);
+	for (size_t i = 0; i < voxels.size(); ++i)
+		layer_start[voxels[i]->index / area + 1]++;
+	for (int l = 0; l < layers; ++l)
+		layer_start[l + 1] += layer_start[l];
+
+	vector<Reconstructor::Voxel*> sorted(voxels.size());
+	vector<int> fill(layer_start.begin(), layer_start.end() - 1);
+	for (size_t i = 0; i < voxels.size(); ++i)
+		sorted[fill[voxels[i]->index / area]++] = voxels[i];
+
+	m_parent.resize(sorted.size());
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		m_slot[sorted[i]->index] = (int) i;
+		m_parent[i] = (int) i;
+	}
+
+	vector<Point3i> offsets;
+	neighbours(offsets);
+
+	// Label every slab on its own, a slab never touches another slab's voxels
+	int s;
+#pragma omp parallel for schedule(dynamic) private(s)
+	for (s = 0; s < slabs; ++s)
+	{
+		const int first_layer = s * slab_layers;
+		const int last_layer = min(first_layer + slab_layers, layers);
+		for (int i = layer_start[first_layer]; i < layer_start[last_layer]; ++i)
+		{
+			const int index = sorted[i]->index;
+			const int z = index / area, y = (index % area) / width, x = index % width;
+			for (size_t o = 0; o < offsets.size(); ++o)
+			{
+				const int nx = x + offsets[o].x, ny = y + offsets[o].y, nz = z + offsets[o].z;
+				if (nx < 0 || nx >= width || ny < 0 || ny >= height || nz < first_layer) continue;
+
+				const int n = m_slot[nz * area + ny * width + nx];
+				if (n >= 0) unite(i, n);
+			}
+		}
+	}
+
+	// Merge across the slab borders: the first layer of a slab with the layer below
+	for (s = 1; s < slabs; ++s)
+	{
+		const int z = s * slab_layers;
+		for (int i = layer_start[z]; i < layer_start[min(z + 1, layers)]; ++i)
+		{
+			const int index = sorted[i]->index;
+			const int y = (index % area) / width, x = index % width;
+			for (size_t o = 0; o < offsets.size(); ++o)
+			{
+				if (offsets[o].z == 0) continue;
+				const int nx = x + offsets[o].x, ny = y + offsets[o].y;
+				if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+
+				const int n = m_slot[(z - 1) * area + ny * width + nx];
+				if (n >= 0) unite(i, n);
+			}
+		}
+	}
+
+	// Component sizes by root
+	vector<int> roots(sorted.size());
+	vector<int> sizes(sorted.size(), 0);
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		roots[i] = find((int) i);
+		sizes[roots[i]]++;
+	}
+
+	// Compact ids for the components that are kept, -1 for the dropped ones
+	vector<int> id_of_root(sorted.size(), -1);
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		if (roots[i] != (int) i || sizes[i] < m_min_size) continue;
+
+		id_of_root[i] = (int) components.size();
+		Component component;
+		component.size = sizes[i];
+		component.min = Point3i(sorted[i]->x, sorted[i]->y, sorted[i]->z);
+		component.max = component.min;
+		components.push_back(component);
+	}
+
+	voxels.clear();
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		Reconstructor::Voxel* voxel = sorted[i];
+		m_slot[voxel->index] = -1;  // Clean for the next frame
+
+		const int id = id_of_root[roots[i]];
+		if (id < 0)
+		{
+			floor[voxel->column]--;
+			continue;
+		}
+
+		Component &component = components[id];
+		component.min.x = min(component.min.x, voxel->x);
+		component.min.y = min(component.min.y, voxel->y);
+		component.min.z = min(component.min.z, voxel->z);
+		component.max.x = max(component.max.x, voxel->x);
+		component.max.y = max(component.max.y, voxel->y);
+		component.max.z = max(component.max.z, voxel->z);
+
+		voxels.push_back(voxel);
+		ids.push_back(id);
+	}
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,91 @@
+/*
+ * ConnectedComponents.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef CONNECTEDCOMPONENTS_H_
+#define CONNECTEDCOMPONENTS_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <vector>
+
+#include "Reconstructor.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Connected blob of visible voxels
+ */
+struct Component
+{
+	int size;                               // Amount of voxels
+	cv::Point3i min, max;                   // Bounding box of the voxel centers (world mm, inclusive)
+};
+
+/*
+ * Connected component labeling of the carved voxels on the voxel grid.
+ * Carving leaves ghost voxels and small noise blobs next to the people,
+ * dropping all components below a minimum size before clustering removes
+ * them from every following stage.
+ *
+ * Union-find: the grid is cut in slabs of floor layers that are labeled in
+ * parallel, after which the slab borders are merged. Keeps its buffers
+ * between frames, so one instance must not be used by two threads at once.
+ */
+class ConnectedComponents
+{
+	const Reconstructor &m_reconstructor;   // Reference to the reconstructor (voxel grid layout)
+	int m_connectivity;                     // 6 (faces) or 26 (faces, edges and corners)
+	int m_min_size;                         // Components with fewer voxels are dropped
+
+	std::vector<int> m_slot;                // Voxel LUT index -> position in the layer sorted voxels (-1: not visible)
+	std::vector<int> m_parent;              // Union-find parent per layer sorted voxel
+
+	int find(
+			int);
+	void unite(
+			int, int);
+	void neighbours(
+			std::vector<cv::Point3i> &) const;
+
+public:
+	ConnectedComponents(
+			const Reconstructor &, int = 26, int = 50);
+	virtual ~ConnectedComponents();
+
+	void label(
+			std::vector<Reconstructor::Voxel*> &, std::vector<int> &, std::vector<int> &, std::vector<Component> &);
+
+	int getConnectivity() const
+	{
+		return m_connectivity;
+	}
+
+	/**
+	 * Anything but 6 means 26
+	 */
+	void setConnectivity(
+			int connectivity)
+	{
+		m_connectivity = connectivity == 6 ? 6 : 26;
+	}
+
+	int getMinSize() const
+	{
+		return m_min_size;
+	}
+
+	void setMinSize(
+			int minSize)
+	{
+		m_min_size = minSize;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* CONNECTEDCOMPONENTS_H_ */
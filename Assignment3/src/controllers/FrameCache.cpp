@@ -0,0 +1,155 @@
+/*
+ * FrameCache.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "FrameCache.h"
+
+#include <stdint.h>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Constructor
+ * capacity: maximum bytes of the cached frames and masks, 0 caches nothing
+ */
+FrameCache::FrameCache(
+		size_t capacity) :
+				m_capacity(capacity),
+				m_bytes(0)
+{
+}
+
+FrameCache::~FrameCache()
+{
+}
+
+/**
+ * Entry of a frame, moved to the front as the most recently used (NULL if not cached)
+ */
+FrameCache::Entry* FrameCache::find(
+		int frame)
+{
+	const unordered_map<int, list<Entry>::iterator>::iterator found = m_index.find(frame);
+	if (found == m_index.end()) return NULL;
+
+	m_entries.splice(m_entries.begin(), m_entries, found->second);
+	return &*found->second;
+}
+
+/**
+ * Entry of a frame, a new empty one in front if not cached
+ */
+FrameCache::Entry& FrameCache::insert(
+		int frame)
+{
+	Entry* entry = find(frame);
+	if (entry != NULL) return *entry;
+
+	Entry empty = { frame, Mat(), BitMask(), 0, 0 };
+	m_entries.push_front(empty);
+	m_index[frame] = m_entries.begin();
+	return m_entries.front();
+}
+
+/**
+ * Drop the least recently used entries until everything fits
+ */
+void FrameCache::evict()
+{
+	while (m_bytes > m_capacity && !m_entries.empty())
+	{
+		m_bytes -= m_entries.back().bytes;
+		m_index.erase(m_entries.back().frame);
+		m_entries.pop_back();
+	}
+}
+
+/**
+ * Recount the memory of a changed entry, then make everything fit again
+ * (the changed entry goes last, it may not fit at all)
+ */
+void FrameCache::update(
+		Entry &entry)
+{
+	m_bytes -= entry.bytes;
+	entry.bytes = entry.image.total() * entry.image.elemSize() + (size_t) entry.mask.rows() * entry.mask.stride() * sizeof(uint64_t);
+	m_bytes += entry.bytes;
+	evict();
+}
+
+/**
+ * The decoded image of a frame, if cached (shares the cached pixels)
+ */
+bool FrameCache::getImage(
+		int frame, Mat &image)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Entry* entry = find(frame);
+	if (entry == NULL || entry->image.empty()) return false;
+
+	image = entry->image;
+	return true;
+}
+
+/**
+ * Cache the decoded image of a frame, the pixels are shared, not copied
+ */
+void FrameCache::putImage(
+		int frame, const Mat &image)
+{
+	lock_guard<mutex> lock(m_mutex);
+	if (m_capacity == 0 || image.empty()) return;
+
+	Entry &entry = insert(frame);
+	entry.image = image;
+	update(entry);
+}
+
+/**
+ * The foreground mask of a frame, if cached in the given segmentation epoch
+ */
+bool FrameCache::getMask(
+		int frame, unsigned epoch, BitMask &mask)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Entry* entry = find(frame);
+	if (entry == NULL || entry->mask.empty() || entry->epoch != epoch) return false;
+
+	mask = entry->mask;
+	return true;
+}
+
+/**
+ * Cache the foreground mask of a frame, segmented in the given epoch
+ */
+void FrameCache::putMask(
+		int frame, unsigned epoch, const BitMask &mask)
+{
+	lock_guard<mutex> lock(m_mutex);
+	if (m_capacity == 0 || mask.empty()) return;
+
+	Entry &entry = insert(frame);
+	entry.mask = mask;
+	entry.epoch = epoch;
+	update(entry);
+}
+
+/**
+ * Change the maximum memory, least recently used entries are dropped to fit
+ */
+void FrameCache::setCapacity(
+		size_t capacity)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_capacity = capacity;
+	evict();
+}
+
+} /* namespace nl_uu_science_gmt */
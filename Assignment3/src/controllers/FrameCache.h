@@ -0,0 +1,87 @@
+/*
+ * FrameCache.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef FRAMECACHE_H_
+#define FRAMECACHE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "../utilities/BitMask.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Least recently used decoded frames and foreground masks of one camera, at
+ * most a given amount of memory. Stepping back or scrubbing over frames that
+ * were just shown then costs a lookup instead of a seek, a decode and a
+ * segmentation.
+ *
+ * Cached frames share their pixels with the images handed out, so those must
+ * never be written to. A mask is stored with the epoch of the segmentation
+ * (see Scene3DRenderer::getForegroundEpoch()) and only handed out in the same
+ * epoch: changing a segmentation setting starts a new one. Masks made while
+ * the background models adapt stay valid, so stepping back and scrubbing are
+ * served from memory at the price of masks slightly behind the models. The decode and segment threads use the cache at the same
+ * time, every call locks it.
+ */
+class FrameCache
+{
+	struct Entry
+	{
+		int frame;                              // Video frame index
+		cv::Mat image;                          // Decoded frame (empty: not cached)
+		BitMask mask;                           // Foreground mask (empty: not cached)
+		unsigned epoch;                         // Segmentation epoch of mask
+		size_t bytes;                           // Memory of image and mask
+	};
+
+	size_t m_capacity;                        // Maximum bytes of all entries (0: caching is off)
+	size_t m_bytes;                           // Bytes of all entries
+	std::list<Entry> m_entries;               // Front is the most recently used
+	std::unordered_map<int, std::list<Entry>::iterator> m_index;  // Entry per frame index
+
+	std::mutex m_mutex;
+
+	Entry* find(
+			int);
+	Entry& insert(
+			int);
+	void evict();
+	void update(
+			Entry &);
+
+public:
+	FrameCache(
+			size_t = 0);
+	virtual ~FrameCache();
+
+	bool getImage(
+			int, cv::Mat &);
+	void putImage(
+			int, const cv::Mat &);
+	bool getMask(
+			int, unsigned, BitMask &);
+	void putMask(
+			int, unsigned, const BitMask &);
+
+	void setCapacity(
+			size_t);
+
+	size_t getCapacity() const
+	{
+		return m_capacity;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* FRAMECACHE_H_ */
@@ -29,8 +29,12 @@
 #include "../utilities/General.h"
 #include "arcball.h"
 #include "Camera.h"
+#include "Clusterer.h"
+#include "Pipeline.h"
 #include "Reconstructor.h"
 #include "Scene3DRenderer.h"
+#include "Tracker.h"
+#include "Trajectories.h"
 
 using namespace std;
 using namespace cv;
@@ -41,15 +45,37 @@ namespace nl_uu_science_gmt
 Glut* Glut::m_Glut;
 
 Glut::Glut(
-		Scene3DRenderer &s3d) :
-				m_scene3d(s3d)
+		Scene3DRenderer &s3d, const string &dp) :
+				m_scene3d(s3d),
+				m_data_path(dp)
 {
 	// static pointer to this class so we can get to it from the static GL events
 	m_Glut = this;
+
+	tracking = false;
+	m_init_models = false;
+
+	m_playing = false;
+	m_refresh = false;
+	m_generation = 0;
+
+	m_clusterer = new Clusterer(4);
+	m_tracker = new Tracker();
+	m_trajectories = new Trajectories(m_scene3d.getReconstructor().getSize());
+	m_floor_plan_version = 0;
+
+	// Processing runs on the pipeline's threads from here on
+	m_pipeline = new Pipeline(m_scene3d);
+	m_pipeline->setClusterStage(clusterStage);
+	m_pipeline->start();
 }
 
 Glut::~Glut()
 {
+	delete m_pipeline;
+	delete m_trajectories;
+	delete m_tracker;
+	delete m_clusterer;
 }
 
 #ifdef __linux__
@@ -93,16 +119,7 @@ void Glut::initializeLinux(
  */
 int Glut::initializeWindows(const char* win_name)
 {
-	//m_Glut->tracking = false;
 	Scene3DRenderer &scene3d = m_Glut->getScene3d();
-	m_Glut->tracking = false;
-	for (size_t i = 0; i < scene3d.getCameras().size(); i++)
-	{
-		m_Glut->g_clusters.push_back(vector<vector<Reconstructor::Voxel*>>());
-		m_Glut->g_clustered_voxels.push_back(vector<vector<Reconstructor::Voxel*>>());
-		m_Glut->g_colors.push_back(vector<Mat>());
-		m_Glut->g_histograms.push_back(vector<Mat>());
-	}
 
 	arcball_reset();	//initialize the ArcBall for scene rotation
 
@@ -266,6 +283,7 @@ void Glut::reset()
 void Glut::quit()
 {
 	m_Glut->getScene3d().setQuit(true);
+	m_Glut->m_pipeline->stop();
 	exit(EXIT_SUCCESS);
 }
 
@@ -357,15 +375,35 @@ void Glut::keyboard(
 		}
 		else if (key == 'k' || key == 'K')
 		{
-			m_Glut->cluster_voxels(true);
-			cout << "New color model from frame \r\n";
+			// Picked up by the cluster stage with the next processed frame
+			m_Glut->m_init_models = true;
+			m_Glut->m_refresh = true;
 		}
 		else if (key == 'l' || key == 'L')
 		{
 			m_Glut->tracking = true;
-			m_Glut->cluster_voxels(false);
+			m_Glut->m_refresh = true;
 			cout << "Starting identification \r\n";
 		}
+		else if (key == 'f' || key == 'F')
+		{
+			bool refining = m_Glut->m_pipeline->isRefining();
+			m_Glut->m_pipeline->setRefining(!refining);
+			m_Glut->m_refresh = true;
+			cout << (refining ? "Photo-consistency off \r\n" : "Photo-consistency on \r\n");
+		}
+		else if (key == 'a' || key == 'A')
+		{
+			bool adapt = scene3d.isAdaptBackground();
+			scene3d.setAdaptBackground(!adapt);
+			cout << (adapt ? "Background adaptation paused \r\n" : "Background adaptation on \r\n");
+		}
+		else if (key == 'w' || key == 'W')
+		{
+			bool written = m_Glut->m_trajectories->writeCsv(m_Glut->m_data_path + General::TrajectoriesCsvFile);
+			written = m_Glut->m_trajectories->writeBinary(m_Glut->m_data_path + General::TrajectoriesFile) && written;
+			cout << (written ? "Trajectories written \r\n" : "Unable to write the trajectories \r\n");
+		}
 	}
 	else if (key_i > 0 && key_i <= (int) scene3d.getCameras().size())
 	{
@@ -640,156 +678,140 @@ float Glut::point_distance(Point2f point1, Point2f point2)
 	return sqrt(pow(point2.x - point1.x, 2) + pow(point2.y - point1.y, 2) * 1.0);
 }
 
-void Glut::cluster_voxels(bool init_models)
+/**
+ * Pipeline cluster stage: label the carved voxels of a frame and,
+ * when asked for, build color models or identify the clusters
+ * Runs on the pipeline's cluster thread, the only one touching the models
+ */
+void Glut::clusterStage(
+		FrameJob &job)
 {
-	Scene3DRenderer& scene3d = m_Glut->getScene3d();
-	Mat labels, centers;
-	int center_amount = 4;
-	vector<Point2f> voxel_space;
-	vector<Reconstructor::Voxel*> voxels = scene3d.getReconstructor().getVisibleVoxels();
-	//60 bins
-	vector<vector<Reconstructor::Voxel*>> m_clusters;
-	vector<Mat> m_colors;
-	vector<Mat> m_histograms;
+	const bool clustered = m_Glut->m_clusterer->cluster(job.visible_voxels, job.floor, job.labels);
 
-	if (voxels.size() <= 0)
+	// A 'k' press stays pending until a frame has enough voxels to build the models from
+	const bool init_models = clustered && m_Glut->m_init_models.load();
+	if (init_models || m_Glut->tracking)
 	{
-		return;
-	}
-
-	for (int i = 0; i < center_amount; i++)
-	{
-		vector<Reconstructor::Voxel*> vec;
-		m_clusters.push_back(vec);
+		m_Glut->cluster_voxels(job, init_models);
 	}
+}
 
-	for (int i = 0; i < voxels.size(); i++)
-	{
-		voxel_space.push_back(Point2f(voxels[i]->x, voxels[i]->y));
-	}
+/**
+ * Color signature of the foreground pixels the voxels project on, in all cameras
+ * members are indices in job.visible_voxels, voxels a camera doesn't see (occluded) are skipped
+ * Every camera is sampled on its own thread, the pixel counts are summed into one signature
+ * mask_scale is the reduction of the foreground masks (see Reconstructor::getMaskScale())
+ */
+ColorSignature Glut::cluster_signature(const vector<int> &members, const FrameJob &job, int mask_scale)
+{
+	vector<ColorSignature> views(job.frames.size());
 
-	bool local_min_check = true;
-	while (local_min_check == true)
+	int c;
+#pragma omp parallel for schedule(static) private(c)
+	for (c = 0; c < (int) views.size(); c++)
 	{
-		kmeans(voxel_space, center_amount, labels, TermCriteria(CV_TERMCRIT_ITER, 10, 1.0), 10, KMEANS_PP_CENTERS, centers);
+		const Mat &frame = job.frames[c];
+		const BitMask &foreground = job.foregrounds[c];
 
-		local_min_check = false;
-		for (int i = 0; i < labels.rows; i++)
+		for (size_t j = 0; j < members.size(); j++)
 		{
-			if (local_min_check == true)
+			Reconstructor::Voxel* voxel = job.visible_voxels.at(members[j]);
+			if (job.visibility[c][members[j]])
 			{
-				return;
-			}
-			Point2f voxel_position = voxel_space[i];
-			Point2f current_center = Point2f(centers.at<float>(labels.at<int>(i), 0), centers.at<float>(labels.at<int>(i), 1));
-			// Calculate difference to current center
-			float current_diff = point_distance(voxel_position, current_center);
-			for (int j = 0; j < center_amount; j++)
-			{
-				Point2f center = Point2f(centers.at<float>(j, 0), centers.at<float>(j, 1));
-				if (current_center == center)
-				{
-					continue;
-				}
-				// Calculate if one of the other centers is closer, if so we start over
-				if (point_distance(voxel_position, center) < current_diff)
+				const Point point = voxel->camera_projection[c];
+				if (foreground.get(min(point.x / mask_scale, foreground.cols() - 1), min(point.y / mask_scale, foreground.rows() - 1)))
 				{
-					// Currently chosen center is further
-					local_min_check = true;
-					cout << "found local min";
-					return;
+					views[c].add(frame.at<Vec3b>(point));
 				}
 			}
-			m_clusters.at(labels.at<int>(i)).push_back(voxels.at(i));
 		}
 	}
 
-	int camera = scene3d.getCurrentCamera();
-	Camera* cam = scene3d.getCameras()[camera];
-	Mat frame;
-	// Use the foreground mask over the frame
-	copyTo(cam->getFrame(), frame, cam->getForegroundImage());
-
-	for (size_t i = 0; i < m_clusters.size(); i++)
+	ColorSignature signature;
+	for (size_t v = 0; v < views.size(); v++)
 	{
-		Mat color_image = Mat(1, m_clusters.at(i).size(), CV_8UC3);
-
-		for (size_t j = 0; j < m_clusters.at(i).size(); j++)
-		{
-			Reconstructor::Voxel* voxel = m_clusters.at(i).at(j);
-			if (voxel->x == 0 && voxel->y == 0)
-			{
-				continue;
-			}
-			if (voxel->valid_camera_projection[camera])
-			{
-				const Point point = voxel->camera_projection[camera];
-				color_image.at<Vec3b>(0, j) = frame.at<Vec3b>(point);
-			}
-		}
+		signature.merge(views[v]);
+	}
 
-		//m_colors.push_back(color_image);
-		Mat hist, hist_norm, hsv_image;
+	signature.normalize();
+	return signature;
+}
 
-		cvtColor(color_image.clone(), hsv_image, CV_BGR2HSV);
+void Glut::cluster_voxels(FrameJob &job, bool init_models)
+{
+	const int center_amount = m_clusterer->getK();
+	const vector<Reconstructor::Voxel*> &voxels = job.visible_voxels;
+	//60 bins
+	vector<vector<Reconstructor::Voxel*>> m_clusters;
+	vector<vector<int>> m_members;
+	const int mask_scale = m_scene3d.getReconstructor().getMaskScale();
 
-		int h_channel = 0, s_channel = 1, v_channel = 2;
-		int channels[] = { h_channel, s_channel, v_channel };
-		int h_bin = 60, s_bin = 60, v_bin = 60;
-		const int bin_sizes[] = { h_bin, s_bin, v_bin };
-		float h_range[] = { 0, 180 }, s_range[] = { 0, 256 }, v_range[] = { 0, 256 };
-		const float* ranges[] = { h_range, s_range, v_range };
-		bool uniform = true; bool accumulate = false;
+	if (voxels.size() <= 0)
+	{
+		return;
+	}
 
-		calcHist(&hsv_image, 1, channels, Mat(), hist, 2, bin_sizes, ranges, true, false);
+	for (int i = 0; i < center_amount; i++)
+	{
+		vector<Reconstructor::Voxel*> vec;
+		m_clusters.push_back(vec);
+		m_members.push_back(vector<int>());
+	}
 
-		normalize(hist, hist_norm, 1.0, 0, 2);
+	// Too few voxels to cluster
+	const vector<int> &labels = job.labels;
+	if (labels.size() != voxels.size())
+	{
+		return;
+	}
 
-		m_histograms.push_back(hist_norm);
+	for (size_t i = 0; i < labels.size(); i++)
+	{
+		m_clusters.at(labels[i]).push_back(voxels.at(i));
+		m_members.at(labels[i]).push_back((int) i);
 	}
 
 	if (init_models)
 	{
-		m_Glut->g_clusters.at(camera) = m_clusters;
-		//m_Glut->g_colors.at(camera) = m_colors;
-		m_Glut->g_histograms.at(camera) = m_histograms;
+		vector<ColorSignature> m_signatures;
+		for (size_t i = 0; i < m_clusters.size(); i++)
+			m_signatures.push_back(cluster_signature(m_members.at(i), job, mask_scale));
+
+		m_Glut->g_clusters = m_clusters;
+		m_Glut->g_signatures = m_signatures;
+		m_tracker->initialize(m_clusterer->getCenters(), m_signatures);
+		m_init_models = false;
+		cout << "New color model from frame " << job.frame << endl;
+
+		// New models, new people
+		m_trajectories->clear();
+		for (size_t i = 0; i < m_clusters.size(); i++)
+			m_trajectories->add(job.frame, (int) i, m_clusterer->getCenters().at(i));
+		job.identities = labels;
 		return;
 	}
 
-	if (g_histograms.at((center_amount - 1)).size() == 0)
+	if (!m_tracker->isInitialized())
 	{
 		cout << "No base color models";
 		return;
 	}
 
-	vector<vector<Reconstructor::Voxel*>> m_clustered_voxels;
-
-	for (size_t i = 0; i < m_histograms.size(); i++)
+	// Person assigned to each cluster, signatures are only computed when the tracker can't tell by position
+	vector<int> identities;
+	m_tracker->update(m_clusterer->getCenters(), [&](int i)
 	{
-		std::vector<Reconstructor::Voxel*> vec;
-		m_clustered_voxels.push_back(vec);
-	}
+		return cluster_signature(m_members.at(i), job, mask_scale);
+	}, identities);
+
+	for (size_t i = 0; i < identities.size(); i++)
+		m_trajectories->add(job.frame, identities[i], m_clusterer->getCenters().at(i));
 
-	for (size_t i = 0; i < m_histograms.size(); i++)
+	job.identities.resize(labels.size());
+	for (size_t i = 0; i < labels.size(); i++)
 	{
-		double best_diff = 0;
-		int best_hist = -1;
-		vector<Mat> model_hists = m_Glut->g_histograms.at(i);
-		for (size_t j = 0; j < model_hists.size(); j++)
-		{
-			double diff = compareHist(model_hists.at(j), m_histograms.at(i), CV_COMP_CORREL);
-			if (diff > best_diff)
-			{
-				best_diff = diff;
-				best_hist = j;
-			}
-		}
-		if (best_hist > -1)
-		{
-			m_clustered_voxels.at(best_hist) = m_clusters.at(i);
-		}
+		job.identities[i] = identities.at(labels[i]);
 	}
-	m_Glut->g_clustered_voxels.at(camera) = m_clustered_voxels;
 
 	return;
 }
@@ -806,6 +828,7 @@ void Glut::update(
 	keyboard(key, 0, 0);  // call glut key handler :)
 
 	Scene3DRenderer& scene3d = m_Glut->getScene3d();
+	Pipeline& pipeline = *m_Glut->m_pipeline;
 	if (scene3d.isQuit())
 	{
 		// Quit signaled
@@ -815,38 +838,50 @@ void Glut::update(
 	{
 		// Go to the start of the video if we've moved beyond the end
 		scene3d.setCurrentFrame(0);
-		for (size_t c = 0; c < scene3d.getCameras().size(); ++c)
-			scene3d.getCameras()[c]->setVideoFrame(scene3d.getCurrentFrame());
 	}
 	if (scene3d.getCurrentFrame() < 0)
 	{
 		// Go to the end of the video if we've moved before the start
 		scene3d.setCurrentFrame(scene3d.getNumberOfFrames() - 2);
-		for (size_t c = 0; c < scene3d.getCameras().size(); ++c)
-			scene3d.getCameras()[c]->setVideoFrame(scene3d.getCurrentFrame());
 	}
+
+	// Tell the processing threads what to work on, this never waits for them
 	if (!scene3d.isPaused())
 	{
-		// If not paused move to the next frame
-		scene3d.setCurrentFrame(scene3d.getCurrentFrame() + 1);
+		if (!m_Glut->m_playing || scene3d.getCurrentFrame() != scene3d.getPreviousFrame())
+		{
+			// Start playing, from the frame the slider or keys moved to if they did
+			const bool moved = scene3d.getCurrentFrame() != scene3d.getPreviousFrame();
+			m_Glut->m_generation = pipeline.play(moved ? scene3d.getCurrentFrame() : scene3d.getCurrentFrame() + 1);
+			scene3d.setPreviousFrame(scene3d.getCurrentFrame());
+			m_Glut->m_playing = true;
+		}
+		m_Glut->m_refresh = false;
+	}
+	else if (m_Glut->m_playing)
+	{
+		// Paused, keep showing the last finished frame
+		m_Glut->m_generation = pipeline.pause();
+		m_Glut->m_playing = false;
 	}
-	if (scene3d.getCurrentFrame() != scene3d.getPreviousFrame())
+	else if (scene3d.getCurrentFrame() != scene3d.getPreviousFrame() || m_Glut->m_refresh)
 	{
-		// If the current frame is different from the last iteration update stuff
-		scene3d.processFrame();
-		scene3d.getReconstructor().update();
+		// The frame changed or a model was requested (when the video is paused)
+		m_Glut->m_generation = pipeline.show(scene3d.getCurrentFrame());
 		scene3d.setPreviousFrame(scene3d.getCurrentFrame());
+		m_Glut->m_refresh = false;
 	}
-	else if (scene3d.getHThreshold() != scene3d.getPHThreshold() || scene3d.getSThreshold() != scene3d.getPSThreshold()
-			|| scene3d.getVThreshold() != scene3d.getPVThreshold())
-	{
-		// Update the scene if one of the HSV sliders was moved (when the video is paused)
-		scene3d.processFrame();
-		scene3d.getReconstructor().update();
 
-		scene3d.setPHThreshold(scene3d.getHThreshold());
-		scene3d.setPSThreshold(scene3d.getSThreshold());
-		scene3d.setPVThreshold(scene3d.getVThreshold());
+	// Swap in the newest processed frame, if it's one we asked for
+	shared_ptr<const VoxelSnapshot> snapshot = pipeline.getSnapshot();
+	if (snapshot && snapshot != m_Glut->m_snapshot && snapshot->generation == m_Glut->m_generation)
+	{
+		m_Glut->m_snapshot = snapshot;
+		if (m_Glut->m_playing)
+		{
+			scene3d.setCurrentFrame(snapshot->frame);
+			scene3d.setPreviousFrame(snapshot->frame);
+		}
 	}
 
 	// Auto rotate the scene
@@ -857,21 +892,18 @@ void Glut::update(
 
 	// Get the image and the foreground image (of set camera)
 	Mat canvas, foreground;
-	if (scene3d.getCurrentCamera() != -1)
-	{
-		canvas = scene3d.getCameras()[scene3d.getCurrentCamera()]->getFrame();
-		foreground = scene3d.getCameras()[scene3d.getCurrentCamera()]->getForegroundImage();
-	}
-	else
+	if (m_Glut->m_snapshot)
 	{
-		canvas = scene3d.getCameras()[scene3d.getPreviousCamera()]->getFrame();
-		foreground = scene3d.getCameras()[scene3d.getPreviousCamera()]->getForegroundImage();
+		const int camera = scene3d.getCurrentCamera() != -1 ? scene3d.getCurrentCamera() : scene3d.getPreviousCamera();
+		canvas = m_Glut->m_snapshot->frames[camera];
+		if (!m_Glut->m_snapshot->foregrounds[camera].empty()) m_Glut->m_snapshot->foregrounds[camera].toMat(foreground);
 	}
 
 	// Concatenate the video frame with the foreground image (of set camera)
 	if (!canvas.empty() && !foreground.empty())
 	{
 		Mat fg_im_3c;
+		if (foreground.size() != canvas.size()) resize(foreground, foreground, canvas.size(), 0, 0, INTER_NEAREST);
 		cvtColor(foreground, fg_im_3c, CV_GRAY2BGR);
 		hconcat(canvas, fg_im_3c, canvas);
 		imshow(VIDEO_WINDOW, canvas);
@@ -881,14 +913,15 @@ void Glut::update(
 		imshow(VIDEO_WINDOW, canvas);
 	}
 
-	// Update the frame slider position
-	setTrackbarPos("Frame", VIDEO_WINDOW, scene3d.getCurrentFrame());
-
-	if (m_Glut->tracking)
+	// Floor plan with the paths walked so far, only copied when it changed
+	if (m_Glut->tracking && m_Glut->m_trajectories->getFloorPlan(m_Glut->m_floor_plan, m_Glut->m_floor_plan_version))
 	{
-		m_Glut->cluster_voxels(false);
+		imshow(FLOOR_WINDOW, m_Glut->m_floor_plan);
 	}
 
+	// Update the frame slider position
+	setTrackbarPos("Frame", VIDEO_WINDOW, scene3d.getCurrentFrame());
+
 #ifdef __linux__
 	glutSwapBuffers();
 	glutTimerFunc(10, update, 0);
@@ -1081,52 +1114,49 @@ void Glut::drawVoxels()
 	glTranslatef(0, 0, 0);
 	glPointSize(2.0f);
 	glBegin(GL_POINTS);
-	Scene3DRenderer* scene3d = &m_Glut->getScene3d();
-	vector<vector<Reconstructor::Voxel*>> voxels;
-	if (m_Glut->tracking)
-	{
-		voxels = m_Glut->g_clustered_voxels.at(scene3d->getCurrentCamera());
-	}
-	else if (m_Glut->g_clusters.size() >= scene3d->getCurrentCamera()) 
-	{
-		voxels = m_Glut->g_clusters.at(scene3d->getCurrentCamera());
-	}
 
-	if (voxels.size() > 0)
+	// Only the display thread touches m_snapshot, the pipeline publishes new ones next to it
+	if (m_Glut->m_snapshot)
 	{
+		const vector<Reconstructor::Voxel*> &voxels = m_Glut->m_snapshot->visible_voxels;
+		const vector<int> &labels = m_Glut->m_snapshot->labels;
+		const vector<Vec3b> &colors = m_Glut->m_snapshot->colors;
+		const bool labeled = labels.size() == voxels.size();
+		const bool colored = colors.size() == voxels.size();
+
 		for (size_t v = 0; v < voxels.size(); v++)
 		{
-			for (size_t j = 0; j < voxels.at(v).size(); j++)
+			const int label = labeled ? labels[v] : -1;
+			if (label == 0)
 			{
-				Reconstructor::Voxel* voxel = voxels.at(v).at(j);
-				if (v == 0)
-				{
-					glColor4f(0, 0, 255, 1);
-				}
-				else if (v == 1)
-				{
-					glColor4f(140, 20, 0, 1);
-				}
-				else if (v == 2)
-				{
-					glColor4f(0, 20, 0, 1);
-				}
-				else if (v == 3)
-				{
-					glColor4f(0, 20, 1400, 1);
-				}
-				glVertex3f((GLfloat)voxel->x, (GLfloat)voxel->y, (GLfloat)voxel->z);
+				glColor4f(0, 0, 255, 1);
 			}
-		}
-	}
-	else
-	{
-		vector<Reconstructor::Voxel*> voxels = m_Glut->getScene3d().getReconstructor().getVisibleVoxels();
-
-		for (size_t v = 0; v < voxels.size(); v++)
-		{
-			glColor3f(voxels[v]->color[0], voxels[v]->color[1], voxels[v]->color[2]);
-			glVertex3f((GLfloat)voxels[v]->x, (GLfloat)voxels[v]->y, (GLfloat)voxels[v]->z);
+			else if (label == 1)
+			{
+				glColor4f(140, 20, 0, 1);
+			}
+			else if (label == 2)
+			{
+				glColor4f(0, 20, 0, 1);
+			}
+			else if (label == 3)
+			{
+				glColor4f(0, 20, 1400, 1);
+			}
+			else if (labeled)
+			{
+				// Unidentified cluster
+				continue;
+			}
+			else if (colored)
+			{
+				glColor3ubv(colors[v].val);
+			}
+			else
+			{
+				glColor3f((GLfloat) voxels[v]->color[0], (GLfloat) voxels[v]->color[1], (GLfloat) voxels[v]->color[2]);
+			}
+			glVertex3f((GLfloat) voxels[v]->x, (GLfloat) voxels[v]->y, (GLfloat) voxels[v]->z);
 		}
 	}
 
@@ -1170,7 +1200,7 @@ void Glut::drawWCoord()
 }
 
 /**
- * Draw camera numbers into scene
+ * Draw camera numbers into scene, with the share of the tiles segmentation skipped
  */
 void Glut::drawInfo()
 {
@@ -1182,12 +1212,17 @@ void Glut::drawInfo()
 	if (m_Glut->getScene3d().isShowInfo())
 	{
 		vector<Camera*> cameras = m_Glut->getScene3d().getCameras();
+		shared_ptr<const VoxelSnapshot> snapshot = m_Glut->m_snapshot;
 		for (size_t c = 0; c < cameras.size(); ++c)
 		{
 			glRasterPos3d(cameras[c]->getCameraLocation().x, cameras[c]->getCameraLocation().y, cameras[c]->getCameraLocation().z);
 			stringstream sstext;
-			sstext << (c + 1) << "\0";
-			for (const char* c = sstext.str().c_str(); *c != '\0'; c++)
+			sstext << (c + 1);
+			if (snapshot && c < snapshot->skipped_tiles.size())
+				sstext << " (" << cvRound(snapshot->skipped_tiles[c] * 100) << "% tiles skipped)";
+			sstext << "\0";
+			const string text = sstext.str();
+			for (const char* c = text.c_str(); *c != '\0'; c++)
 			{
 				glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
 			}
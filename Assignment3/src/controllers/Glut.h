@@ -8,6 +8,11 @@
 #ifndef GLUT_H_
 #define GLUT_H_
 
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "../utilities/ColorSignature.h"
 #include "Reconstructor.h"
 
 #ifdef _WIN32
@@ -34,11 +39,18 @@ namespace nl_uu_science_gmt
 {
 
 class Scene3DRenderer;
+class Pipeline;
+class Clusterer;
+class Tracker;
+class Trajectories;
+struct FrameJob;
+struct VoxelSnapshot;
 
 class Glut
 {
 private:
 	Scene3DRenderer &m_scene3d;
+	const std::string m_data_path;            // Path to data directory, the trajectories are written there
 
 	static Glut* m_Glut;
 
@@ -58,20 +70,35 @@ private:
 	static LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 #endif
 
-	std::vector<std::vector<std::vector<Reconstructor::Voxel*>>> g_clusters;
-	std::vector<std::vector<cv::Mat>> g_colors;
-	std::vector<std::vector<cv::Mat>> g_histograms;
+	std::vector<std::vector<Reconstructor::Voxel*>> g_clusters;  // Clusters the color models were built from
+	std::vector<ColorSignature> g_signatures;                   // Color model per person, fused from all cameras
 
-	std::vector<std::vector<std::vector<Reconstructor::Voxel*>>> g_clustered_voxels;
-	std::vector<std::vector<std::vector<Reconstructor::Voxel*>>> g_path;
-	bool tracking;
+	std::atomic<bool> tracking;
+
+	Pipeline* m_pipeline;                     // Processing threads (decode/segment/carve/cluster)
+	Clusterer* m_clusterer;                   // Temporal k-means, cluster thread only
+	Tracker* m_tracker;                       // Person tracks, cluster thread only
+	Trajectories* m_trajectories;             // Paths of the tracked people
+	std::atomic<bool> m_init_models;          // flag cluster stage builds new color models
+
+	// Display thread only
+	std::shared_ptr<const VoxelSnapshot> m_snapshot;  // Processed frame that's being drawn
+	unsigned m_generation;                    // Pipeline request the shown snapshots must belong to
+	bool m_playing;                           // flag pipeline was asked to play
+	bool m_refresh;                           // flag current frame must be processed again
+	cv::Mat m_floor_plan;                     // Last shown copy of the trajectories floor plan
+	unsigned m_floor_plan_version;            // Version of m_floor_plan
+
+	static void clusterStage(
+			FrameJob &);
 
 public:
 	Glut(
-			Scene3DRenderer &);
+			Scene3DRenderer &, const std::string &);
 	virtual ~Glut();
-	float point_distance(cv::Point2f point1, cv::Point2f point2);
-	void cluster_voxels(bool init_models);
+	static float point_distance(cv::Point2f point1, cv::Point2f point2);
+	void cluster_voxels(FrameJob &job, bool init_models);
+	static ColorSignature cluster_signature(const std::vector<int> &members, const FrameJob &job, int mask_scale);
 
 	void track_histograms();
 
@@ -0,0 +1,348 @@
+/*
+ * Pipeline.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "Pipeline.h"
+
+#include <cassert>
+
+#include "Camera.h"
+#include "Scene3DRenderer.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Constructor
+ * Stage threads are only started by start()
+ */
+Pipeline::Pipeline(
+		Scene3DRenderer &s3d, size_t depth) :
+				m_scene3d(s3d),
+				m_depth(depth > 0 ? depth : 1),
+				m_running(false),
+				m_coloring(true),
+				m_refining(false),
+				m_generation(0),
+				m_decoded(m_depth),
+				m_segmented(m_depth),
+				m_carved(m_depth)
+{
+	m_request.generation = 0;
+	m_request.frame = -1;
+	m_request.play = false;
+
+	m_components = new ConnectedComponents(m_scene3d.getReconstructor());
+}
+
+/**
+ * Deconstructor
+ * Stop the stage threads and free the frames still in flight
+ */
+Pipeline::~Pipeline()
+{
+	stop();
+	delete m_components;
+}
+
+/**
+ * Start the stage threads, they idle until the first request
+ */
+void Pipeline::start()
+{
+	stop();
+
+	m_decoded.reopen(m_depth);
+	m_segmented.reopen(m_depth);
+	m_carved.reopen(m_depth);
+
+	m_running = true;
+
+	m_threads.push_back(thread(&Pipeline::decode, this));
+	m_threads.push_back(thread(&Pipeline::segment, this));
+	m_threads.push_back(thread(&Pipeline::carve, this));
+	m_threads.push_back(thread(&Pipeline::cluster, this));
+}
+
+/**
+ * Stop all stages and throw away the frames that haven't been published yet
+ */
+void Pipeline::stop()
+{
+	{
+		lock_guard<mutex> lock(m_request_mutex);
+		m_running = false;
+		m_request_changed.notify_all();
+	}
+
+	m_decoded.close();
+	m_segmented.close();
+	m_carved.close();
+
+	for (size_t t = 0; t < m_threads.size(); ++t)
+		m_threads[t].join();
+	m_threads.clear();
+
+	drain(m_decoded);
+	drain(m_segmented);
+	drain(m_carved);
+}
+
+/**
+ * Replace the current request, frames of older requests still in flight are dropped
+ * Returns the generation the resulting snapshots will carry
+ */
+unsigned Pipeline::post(
+		int frame, bool play)
+{
+	lock_guard<mutex> lock(m_request_mutex);
+	m_request.generation++;
+	m_request.frame = frame;
+	m_request.play = play;
+	m_generation = m_request.generation;
+	m_request_changed.notify_all();
+	return m_request.generation;
+}
+
+/**
+ * Process the given frame and all frames after it
+ */
+unsigned Pipeline::play(
+		int frame)
+{
+	return post(frame, true);
+}
+
+/**
+ * Process only the given frame
+ */
+unsigned Pipeline::show(
+		int frame)
+{
+	return post(frame, false);
+}
+
+/**
+ * Stop decoding, the frames in flight are dropped
+ */
+unsigned Pipeline::pause()
+{
+	return post(-1, false);
+}
+
+/**
+ * The newest published snapshot (NULL until the first frame is done)
+ */
+shared_ptr<const VoxelSnapshot> Pipeline::getSnapshot() const
+{
+	return atomic_load(&m_snapshot);
+}
+
+/**
+ * A job is stale when the display thread posted a new request after it was decoded
+ */
+bool Pipeline::isStale(
+		const FrameJob* job) const
+{
+	return job->generation != m_generation;
+}
+
+/**
+ * Free all jobs left in a (closed) queue
+ */
+void Pipeline::drain(
+		BoundedQueue<FrameJob*> &queue)
+{
+	FrameJob* job;
+	while (queue.tryPop(job))
+		delete job;
+}
+
+/**
+ * Stage 1: read the requested frame(s) of every camera
+ * Wraps around to the start of the video like the interactive playback does
+ */
+void Pipeline::decode()
+{
+	const vector<Camera*> &cameras = m_scene3d.getCameras();
+	const int last_frame = (int) m_scene3d.getNumberOfFrames() - 2;
+
+	unsigned generation = 0;
+	int frame = -1;                  // Next frame to decode, -1 when idle
+	bool play = false;
+
+	while (m_running)
+	{
+		{
+			unique_lock<mutex> lock(m_request_mutex);
+			while (m_running && m_request.generation == generation && frame < 0)
+				m_request_changed.wait(lock);
+			if (!m_running) return;
+
+			if (m_request.generation != generation)
+			{
+				generation = m_request.generation;
+				frame = m_request.frame;
+				play = m_request.play;
+			}
+		}
+		if (frame < 0) continue;
+		if (frame > last_frame) frame = 0;
+
+		FrameJob* job = new FrameJob;
+		job->frame = frame;
+		job->generation = generation;
+		job->frames.resize(cameras.size());
+
+		// A camera only seeks when the frame isn't cached and isn't the next one of its video
+		bool decoded = true;
+		for (size_t c = 0; c < cameras.size(); ++c)
+			decoded = cameras[c]->readVideoFrame(frame, job->frames[c]) && decoded;
+
+		if (!decoded)
+		{
+			// Premature end of a video, start over
+			delete job;
+			frame = play ? 0 : -1;
+			continue;
+		}
+
+		if (!m_decoded.push(job))
+		{
+			delete job;
+			return;
+		}
+		frame = play ? frame + 1 : -1;
+	}
+}
+
+/**
+ * Stage 2: foreground segmentation, the cameras of a frame (and bands of every camera) in parallel
+ * The masks still in a camera's frame cache are reused (all tiles count as skipped),
+ * as long as nothing they depend on changed since (see Scene3DRenderer::getForegroundEpoch())
+ *
+ * The epoch is taken once per job, before segmenting: a setting changes before the
+ * epoch does, so the masks are made with settings at least as new as their epoch.
+ * Masks made with a setting that changed meanwhile are stored under an epoch that
+ * has already passed, so no job that starts after the change gets them.
+ */
+void Pipeline::segment()
+{
+	const vector<Camera*> &cameras = m_scene3d.getCameras();
+
+	FrameJob* job;
+	while (m_decoded.pop(job))
+	{
+		if (isStale(job))
+		{
+			delete job;
+			continue;
+		}
+
+		job->foregrounds.resize(cameras.size());
+		job->skipped_tiles.assign(cameras.size(), 1.f);
+
+		job->epoch = m_scene3d.getForegroundEpoch();
+		vector<size_t> missing;
+		vector<Camera*> missing_cameras;
+		vector<Mat> missing_frames;
+		for (size_t c = 0; c < cameras.size(); ++c)
+		{
+			if (cameras[c]->getFrameCache().getMask(job->frame, job->epoch, job->foregrounds[c])) continue;
+			missing.push_back(c);
+			missing_cameras.push_back(cameras[c]);
+			missing_frames.push_back(job->frames[c]);
+		}
+
+		if (!missing.empty())
+		{
+			vector<BitMask> foregrounds;
+			vector<float> skipped;
+			m_scene3d.processForegrounds(missing_cameras, missing_frames, foregrounds, skipped);
+
+			for (size_t m = 0; m < missing.size(); ++m)
+			{
+				missing_cameras[m]->getFrameCache().putMask(job->frame, job->epoch, foregrounds[m]);
+				swap(job->foregrounds[missing[m]], foregrounds[m]);
+				job->skipped_tiles[missing[m]] = skipped[m];
+			}
+		}
+
+		if (!m_segmented.push(job))
+		{
+			delete job;
+			return;
+		}
+	}
+}
+
+/**
+ * Stage 3: voxel carving, (optionally) photo-consistency refinement, the removal
+ * of the small components, the visibility of the remaining voxels per camera
+ * and (optionally) their colors
+ */
+void Pipeline::carve()
+{
+	const Reconstructor &reconstructor = m_scene3d.getReconstructor();
+
+	FrameJob* job;
+	while (m_segmented.pop(job))
+	{
+		if (isStale(job))
+		{
+			delete job;
+			continue;
+		}
+
+		reconstructor.carve(job->foregrounds, job->visible_voxels, job->floor);
+		if (m_refining) reconstructor.refine(job->frames, job->visible_voxels, job->floor);
+		m_components->label(job->visible_voxels, job->floor, job->component_ids, job->components);
+		reconstructor.visibility(job->visible_voxels, job->visibility);
+		if (m_coloring) reconstructor.color(job->frames, job->visible_voxels, job->visibility, job->colors);
+
+		if (!m_carved.push(job))
+		{
+			delete job;
+			return;
+		}
+	}
+}
+
+/**
+ * Stage 4: clustering of the visible voxels (if a cluster stage is set),
+ * then publish the frame as the newest snapshot
+ */
+void Pipeline::cluster()
+{
+	FrameJob* job;
+	while (m_carved.pop(job))
+	{
+		if (!isStale(job))
+		{
+			if (m_cluster_stage) m_cluster_stage(*job);
+
+			VoxelSnapshot* snapshot = new VoxelSnapshot;
+			snapshot->frame = job->frame;
+			snapshot->generation = job->generation;
+			snapshot->frames.swap(job->frames);
+			snapshot->foregrounds.swap(job->foregrounds);
+			snapshot->skipped_tiles.swap(job->skipped_tiles);
+			snapshot->visible_voxels.swap(job->visible_voxels);
+			snapshot->component_ids.swap(job->component_ids);
+			snapshot->components.swap(job->components);
+			snapshot->colors.swap(job->colors);
+			snapshot->labels.swap(job->identities);
+
+			atomic_store(&m_snapshot, shared_ptr<const VoxelSnapshot>(snapshot));
+		}
+		delete job;
+	}
+}
+
+} /* namespace nl_uu_science_gmt */
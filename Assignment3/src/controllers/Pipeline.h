@@ -0,0 +1,203 @@
+/*
+ * Pipeline.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../utilities/BoundedQueue.h"
+#include "ConnectedComponents.h"
+#include "Reconstructor.h"
+
+namespace nl_uu_science_gmt
+{
+
+class Scene3DRenderer;
+
+/*
+ * Everything computed for one video frame, handed from stage to stage
+ */
+struct FrameJob
+{
+	int frame;                                          // Video frame index
+	unsigned generation;                                // Request this frame belongs to
+	std::vector<cv::Mat> frames;                        // Decoded image per camera
+	std::vector<BitMask> foregrounds;                   // Foreground mask per camera
+	unsigned epoch;                                     // Foreground epoch of the masks (see Scene3DRenderer::getForegroundEpoch())
+	std::vector<float> skipped_tiles;                   // Fraction of unchanged tiles segmentation skipped, per camera
+	std::vector<Reconstructor::Voxel*> visible_voxels;  // Voxels that survived carving
+	std::vector<int> floor;                             // Visible voxel count per floor grid column
+	std::vector<int> component_ids;                     // Connected component per visible voxel
+	std::vector<Component> components;                  // Connected components that were kept
+	std::vector<std::vector<uchar>> visibility;         // Per camera, flag visible voxel is not occluded
+	std::vector<cv::Vec3b> colors;                      // RGB per visible voxel (empty if coloring is off)
+	std::vector<int> labels;                            // Cluster label per visible voxel
+	std::vector<int> identities;                        // Person per visible voxel (empty if not identified)
+};
+
+/*
+ * Immutable result of one processed frame, shared between the processing
+ * threads and the display thread. A snapshot is never changed after it has
+ * been published, the display thread simply keeps a reference to the one it's
+ * drawing while the pipeline publishes the next.
+ */
+struct VoxelSnapshot
+{
+	int frame;                                          // Video frame index
+	unsigned generation;                                // Request this frame belongs to
+	std::vector<cv::Mat> frames;                        // Decoded image per camera
+	std::vector<BitMask> foregrounds;                   // Foreground mask per camera
+	std::vector<float> skipped_tiles;                   // Fraction of unchanged tiles segmentation skipped, per camera
+	std::vector<Reconstructor::Voxel*> visible_voxels;  // Voxels that survived carving
+	std::vector<int> component_ids;                     // Connected component per visible voxel
+	std::vector<Component> components;                  // Connected components that were kept
+	std::vector<cv::Vec3b> colors;                      // RGB per visible voxel (empty if coloring is off)
+	std::vector<int> labels;                            // Person per visible voxel (empty if not identified)
+};
+
+/*
+ * Runs decode, segmentation, carving and clustering of consecutive frames
+ * concurrently, each stage on its own thread, connected by bounded queues.
+ * While frame f is being carved, frame f+1 is segmented and f+2 decoded,
+ * so throughput is set by the slowest stage instead of the sum of all stages.
+ * The queue depth trades latency (1: at most one frame waiting per stage)
+ * for throughput (more frames buffered to absorb stage jitter).
+ *
+ * The display thread only posts requests (play(), show(), pause()) and picks
+ * up the newest published snapshot, so it never waits for processing.
+ */
+class Pipeline
+{
+public:
+	typedef std::function<void(FrameJob &)> Stage;
+
+private:
+	/*
+	 * What the display thread wants the pipeline to work on
+	 */
+	struct Request
+	{
+		unsigned generation;                    // Incremented with every request
+		int frame;                              // First frame to decode, -1 for none
+		bool play;                              // flag keep decoding the following frames
+	};
+
+	Scene3DRenderer &m_scene3d;               // Reference to the scene (cameras, segmentation, reconstructor)
+	size_t m_depth;                           // Capacity of each queue between two stages
+	Stage m_cluster_stage;                    // Optional clustering step, run on the carved voxels
+	ConnectedComponents* m_components;        // Removes the small blobs right after carving
+
+	std::atomic<bool> m_running;              // flag stage threads are running
+	std::atomic<bool> m_coloring;             // flag carve stage colors the visible voxels
+	std::atomic<bool> m_refining;             // flag carve stage runs the photo-consistency refinement
+
+	Request m_request;                        // Latest request of the display thread
+	std::atomic<unsigned> m_generation;       // Generation of m_request, to drop stale frames early
+	std::mutex m_request_mutex;
+	std::condition_variable m_request_changed;
+
+	std::shared_ptr<const VoxelSnapshot> m_snapshot;  // Latest published result (atomic access only)
+
+	BoundedQueue<FrameJob*> m_decoded;        // decode -> segment
+	BoundedQueue<FrameJob*> m_segmented;      // segment -> carve
+	BoundedQueue<FrameJob*> m_carved;         // carve -> cluster
+
+	std::vector<std::thread> m_threads;
+
+	void decode();
+	void segment();
+	void carve();
+	void cluster();
+
+	unsigned post(
+			int, bool);
+	bool isStale(
+			const FrameJob*) const;
+	static void drain(
+			BoundedQueue<FrameJob*> &);
+
+public:
+	Pipeline(
+			Scene3DRenderer &, size_t = 2);
+	virtual ~Pipeline();
+
+	void start();
+	void stop();
+
+	unsigned play(
+			int);
+	unsigned show(
+			int);
+	unsigned pause();
+
+	std::shared_ptr<const VoxelSnapshot> getSnapshot() const;
+
+	bool isRunning() const
+	{
+		return m_running;
+	}
+
+	size_t getDepth() const
+	{
+		return m_depth;
+	}
+
+	/**
+	 * The new depth takes effect at the next start()
+	 */
+	void setDepth(
+			size_t depth)
+	{
+		m_depth = depth > 0 ? depth : 1;
+	}
+
+	ConnectedComponents& getConnectedComponents()
+	{
+		return *m_components;
+	}
+
+	bool isColoring() const
+	{
+		return m_coloring;
+	}
+
+	void setColoring(
+			bool coloring)
+	{
+		m_coloring = coloring;
+	}
+
+	bool isRefining() const
+	{
+		return m_refining;
+	}
+
+	void setRefining(
+			bool refining)
+	{
+		m_refining = refining;
+	}
+
+	void setClusterStage(
+			const Stage &stage)
+	{
+		m_cluster_stage = stage;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* PIPELINE_H_ */
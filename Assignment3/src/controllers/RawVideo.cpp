@@ -0,0 +1,215 @@
+/*
+ * RawVideo.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "RawVideo.h"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../utilities/General.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Start of a raw video file, the frames start at RAW_DATA_OFFSET
+ */
+struct RawHeader
+{
+	char magic[8];                          // RAW_MAGIC
+	int32_t version;                        // RAW_VERSION
+	int32_t width, height;                  // Frame size (CV_8UC3)
+	int32_t frames;                         // Amount of frames
+	int64_t source_size;                    // Bytes of the video the frames were decoded from
+};
+
+static const char RAW_MAGIC[8] = "RAWBGR";
+static const int32_t RAW_VERSION = 1;
+static const size_t RAW_DATA_OFFSET = 4096;  // A page, so the frames start page aligned
+
+RawVideo::RawVideo() :
+		m_data(NULL),
+		m_size(0),
+		m_frames(0)
+{
+}
+
+RawVideo::~RawVideo()
+{
+	close();
+}
+
+/**
+ * Decode all frames of a video into a raw video file
+ * The file is written under a temporary name first, so an interrupted
+ * transcode never leaves a file that looks complete
+ */
+bool RawVideo::transcode(
+		const string &video_file, const string &raw_file)
+{
+	VideoCapture video(video_file);
+	if (!video.isOpened())
+	{
+		cerr << "Unable to open video: " << video_file << endl;
+		return false;
+	}
+
+	const string part_file = raw_file + ".part";
+	ofstream out(part_file.c_str(), ios::binary | ios::trunc);
+	if (!out.is_open())
+	{
+		cerr << "Unable to write: " << part_file << endl;
+		return false;
+	}
+
+	const vector<char> padding(RAW_DATA_OFFSET, 0);
+	out.write(&padding[0], padding.size());
+
+	RawHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RAW_MAGIC, sizeof(header.magic));
+	header.version = RAW_VERSION;
+	header.source_size = General::fsize(video_file);
+
+	Mat frame;
+	while (video.read(frame))
+	{
+		if (header.frames == 0)
+		{
+			header.width = frame.cols;
+			header.height = frame.rows;
+		}
+		if (frame.type() != CV_8UC3 || frame.cols != header.width || frame.rows != header.height) break;
+
+		for (int y = 0; y < frame.rows; ++y)
+			out.write((const char*) frame.ptr<uchar>(y), frame.cols * frame.elemSize());
+		++header.frames;
+	}
+	video.release();
+
+	out.seekp(0);
+	out.write((const char*) &header, sizeof(header));
+	out.close();
+
+	if (!out || header.frames == 0)
+	{
+		cerr << "Unable to transcode: " << video_file << endl;
+		remove(part_file.c_str());
+		return false;
+	}
+
+	remove(raw_file.c_str());
+	return rename(part_file.c_str(), raw_file.c_str()) == 0;
+}
+
+/**
+ * Map a raw video file, made by transcode() from a video of source_size bytes
+ * Fails for a file of another version or of another video
+ */
+bool RawVideo::open(
+		const string &raw_file, long long source_size)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(raw_file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart >= (LONGLONG) RAW_DATA_OFFSET)
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) return false;
+
+	// The view keeps the mapping (and the file) open
+	m_data = (const uchar*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (m_data == NULL) return false;
+	m_size = (size_t) size.QuadPart;
+#else
+	const int file = ::open(raw_file.c_str(), O_RDONLY);
+	if (file < 0) return false;
+
+	struct stat status;
+	void* data = MAP_FAILED;
+	if (fstat(file, &status) == 0 && status.st_size >= (off_t) RAW_DATA_OFFSET)
+		data = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_SHARED, file, 0);
+	::close(file);
+	if (data == MAP_FAILED) return false;
+
+	// The mapping keeps the file open
+	m_data = (const uchar*) data;
+	m_size = (size_t) status.st_size;
+#endif
+
+	RawHeader header;
+	memcpy(&header, m_data, sizeof(header));
+	const size_t frame_bytes = (size_t) header.width * header.height * 3;
+	if (memcmp(header.magic, RAW_MAGIC, sizeof(header.magic)) != 0 || header.version != RAW_VERSION
+			|| header.source_size != source_size || header.frames <= 0
+			|| m_size < RAW_DATA_OFFSET + header.frames * frame_bytes)
+	{
+		close();
+		return false;
+	}
+
+	m_frame_size = Size(header.width, header.height);
+	m_frames = header.frames;
+	return true;
+}
+
+/**
+ * Unmap the file, the frames handed out must no longer be used
+ */
+void RawVideo::close()
+{
+	if (m_data != NULL)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap((void*) m_data, m_size);
+#endif
+	}
+	m_data = NULL;
+	m_size = 0;
+	m_frame_size = Size();
+	m_frames = 0;
+}
+
+/**
+ * The pixels of a frame, in place (empty if there's no such frame)
+ * The mapping is read only, writing to the frame crashes
+ */
+Mat RawVideo::getFrame(
+		int frame_number) const
+{
+	if (m_data == NULL || frame_number < 0 || frame_number >= m_frames) return Mat();
+
+	const size_t frame_bytes = (size_t) m_frame_size.area() * 3;
+	return Mat(m_frame_size, CV_8UC3, (void*) (m_data + RAW_DATA_OFFSET + frame_number * frame_bytes));
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,68 @@
+/*
+ * RawVideo.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef RAWVIDEO_H_
+#define RAWVIDEO_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <string>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Decoded frames of a video in one uncompressed file, memory mapped read only.
+ * A frame is a Mat header on the mapped pixels: nothing is decoded or copied,
+ * the operating system pages the pixels in (and keeps them in its file cache
+ * for the next run).
+ *
+ * The file is made once from the video by transcode(): a header (with the
+ * size of the source video, to notice a replaced video) padded to a page,
+ * then all frames as BGR pixels. It takes frame width x height x 3 bytes per
+ * frame of disk space.
+ */
+class RawVideo
+{
+	const uchar* m_data;                    // Mapped file (NULL: not open)
+	size_t m_size;                          // Bytes mapped
+	cv::Size m_frame_size;                  // Frame width and height
+	int m_frames;                           // Frames in the file
+
+public:
+	RawVideo();
+	virtual ~RawVideo();
+
+	static bool transcode(
+			const std::string &, const std::string &);
+
+	bool open(
+			const std::string &, long long);
+	void close();
+
+	cv::Mat getFrame(
+			int) const;
+
+	bool isOpened() const
+	{
+		return m_data != NULL;
+	}
+
+	int getFrames() const
+	{
+		return m_frames;
+	}
+
+	const cv::Size& getFrameSize() const
+	{
+		return m_frame_size;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* RAWVIDEO_H_ */
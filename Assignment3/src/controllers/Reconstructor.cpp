@@ -13,6 +13,8 @@
 #include <opencv2/core/operations.hpp>
 #include <opencv2/core/types_c.h>
 #include <cassert>
+#include <cfloat>
+#include <cmath>
 #include <iostream>
 
 #include "../utilities/General.h"
@@ -29,12 +31,19 @@ namespace nl_uu_science_gmt
 /**
  * Constructor
  * Voxel reconstruction class
+ * max_mask_scale > 1 lets the cameras segment at a reduced resolution that
+ * still resolves the voxels (see chooseMaskScale()), 1 keeps the full resolution
  */
 Reconstructor::Reconstructor(
-		const vector<Camera*> &cs) :
+		const vector<Camera*> &cs, int max_mask_scale) :
 				m_cameras(cs),
 				m_height(2048),
-				m_step(32)
+				m_step(32),
+				m_photo_sweeps(2),
+				m_photo_threshold(40),
+				m_roi_margin(4),
+				m_max_mask_scale(max_mask_scale),
+				m_mask_scale(1)
 {
 	for (size_t c = 0; c < m_cameras.size(); ++c)
 	{
@@ -46,9 +55,14 @@ Reconstructor::Reconstructor(
 
 	const size_t edge = 2 * m_height;
 	m_voxels_amount = (edge / m_step) * (edge / m_step) * (m_height / m_step);
-
+	m_floor_size = Size((int) (edge / m_step), (int) (edge / m_step));
+
 	//m_voxels_amount = (m_width / m_step) * (m_width / m_step) * (m_height / m_step);
 
+	// Every camera one vote, all of them needed
+	m_votes.assign(m_cameras.size(), 1);
+	m_min_votes = (int) m_cameras.size();
+
 	initialize();
 }
 
@@ -96,9 +110,32 @@ void Reconstructor::initialize()
 	m_corners.push_back(new Point3f((float) xR, (float) yR, (float) zR));
 	m_corners.push_back(new Point3f((float) xR, (float) yL, (float) zR));
 
+	// Per camera, a voxel's footprint times its distance: its footprint anywhere
+	m_splat_spans.assign(m_cameras.size(), 0);
+	for (size_t c = 0; c < m_cameras.size(); ++c)
+	{
+		const Point3f &eye = m_cameras[c]->getCameraLocation();
+		for (size_t k = 0; k < m_corners.size(); ++k)
+		{
+			const Point3f &corner = *m_corners[k];
+			const float dx = corner.x - eye.x, dy = corner.y - eye.y, dz = corner.z - eye.z;
+			const double distance = sqrt(dx * dx + dy * dy + dz * dz);
+			m_splat_spans[c] = max(m_splat_spans[c], (float) (footprint(c, corner) * distance));
+		}
+	}
+
+	// Foreground masks at a reduced resolution, the LUT points at the mask pixels
+	m_mask_scale = chooseMaskScale();
+	m_mask_size = Size(m_plane_size.width / m_mask_scale, m_plane_size.height / m_mask_scale);
+	for (size_t c = 0; c < m_cameras.size(); ++c)
+		m_cameras[c]->setMaskScale(m_mask_scale);
+
 	// Acquire some memory for efficiency
 	cout << "Initializing " << m_voxels_amount << " voxels ";
 	m_voxels.resize(m_voxels_amount);
+	m_pixel_offsets.assign(m_cameras.size(), vector<int>(m_voxels_amount, 0));
+	m_in_view.assign(m_cameras.size(), vector<uchar>(m_voxels_amount, 0));
+	const int row_bits = BitMask::rowBits(m_mask_size.width);
 
 	this->cam1.push_back(Mat());
 	this->cam1.push_back(Mat());
@@ -135,11 +172,13 @@ void Reconstructor::initialize()
 				voxel->x = x;
 				voxel->y = y + m_step;
 				voxel->z = z;
+				voxel->column = yp * plane_x + xp;
 				//voxel->color = Scalar(0, 0, 255);
 				voxel->camera_projection = vector<Point>(m_cameras.size());
 				voxel->valid_camera_projection = vector<int>(m_cameras.size(), 0);
 
 				const int p = zp * plane + yp * plane_x + xp;  // The voxel's index
+				voxel->index = p;
 
 				for (size_t c = 0; c < m_cameras.size(); ++c)
 				{
@@ -159,6 +198,9 @@ void Reconstructor::initialize()
 						voxel->color = Scalar(color_point[0], color_point[1], color_point[2]);*/
 
 						voxel->valid_camera_projection[(int)c] = 1;
+						const Point mask_point = toMask(point);
+						m_pixel_offsets[c][p] = mask_point.y * row_bits + mask_point.x;
+						m_in_view[c][p] = 1;
 					}
 				}
 
@@ -169,55 +211,307 @@ void Reconstructor::initialize()
 	}
 
 	cout << "done!" << endl;
+
+	createRoiSpans();
 }
 
 /**
- * Count the amount of camera's each voxel in the space appears on,
- * if that amount equals the amount of cameras, add that voxel to the
- * visible_voxels vector
+ * Projected size (pixels) in camera c of a voxel at a point: its longest
+ * edge on the image
  */
-void Reconstructor::update()
+double Reconstructor::footprint(
+		size_t c, const Point3f &point) const
 {
-	m_visible_voxels.clear();
-	std::vector<Voxel*> visible_voxels;
+	const Point center = m_cameras[c]->projectOnView(point);
+	const Point dx = m_cameras[c]->projectOnView(point + Point3f((float) m_step, 0, 0)) - center;
+	const Point dy = m_cameras[c]->projectOnView(point + Point3f(0, (float) m_step, 0)) - center;
+	const Point dz = m_cameras[c]->projectOnView(point + Point3f(0, 0, (float) m_step)) - center;
+	return max(norm(dx), max(norm(dy), norm(dz)));
+}
 
-	int v;
-#pragma omp parallel for schedule(static) private(v) shared(visible_voxels)
-	for (v = 0; v < (int)m_voxels_amount; ++v)
+/**
+ * Factor to scale the foreground masks down by: the largest power of two (at most
+ * m_max_mask_scale) at which a voxel still covers a mask pixel: the
+ * smallest projected voxel edge over the volume corners and the cameras
+ */
+int Reconstructor::chooseMaskScale() const
+{
+	if (m_max_mask_scale <= 1) return 1;
+
+	double smallest = DBL_MAX;
+	for (size_t c = 0; c < m_cameras.size(); ++c)
+	{
+		for (size_t k = 0; k < m_corners.size(); ++k)
+			smallest = min(smallest, footprint(c, *m_corners[k]));
+	}
+
+	int scale = 1;
+	while (scale * 2 <= m_max_mask_scale && scale * 2 <= smallest)
+		scale *= 2;
+
+	cout << "Smallest voxel footprint " << cvRound(smallest) << " pixels, segmenting at 1/" << scale << " resolution" << endl;
+	return scale;
+}
+
+/**
+ * Per camera, the mask pixels of every row that carving can depend on: the
+ * span of the voxel projections, widened by m_roi_margin. A 5x5 closing of
+ * the mask reads 4 pixels around a pixel, so the mask is exact at every
+ * projection. Segmentation is restricted to these spans.
+ */
+void Reconstructor::createRoiSpans()
+{
+	int c;
+#pragma omp parallel for schedule(static) private(c)
+	for (c = 0; c < (int) m_cameras.size(); ++c)
 	{
-		int camera_counter = 0;
-		Voxel* voxel = m_voxels[v];
-		for (size_t c = 0; c < m_cameras.size(); ++c)
+		vector<Vec2i> spans(m_mask_size.height, Vec2i(m_mask_size.width, -1));
+		for (size_t p = 0; p < m_voxels_amount; ++p)
 		{
-			if (voxel->valid_camera_projection[c])
+			if (!m_in_view[c][p]) continue;
+
+			const Point point = toMask(m_voxels[p]->camera_projection[c]);
+			const int first = max(point.x - m_roi_margin, 0);
+			const int last = min(point.x + m_roi_margin, m_mask_size.width - 1);
+			const int bottom = min(point.y + m_roi_margin, m_mask_size.height - 1);
+			for (int y = max(point.y - m_roi_margin, 0); y <= bottom; ++y)
 			{
-				/*if (c == 0)
-				{
-					updateColorModel(cam1, m_cameras[c]->getFrame());
-				}*/
-				const Point point = voxel->camera_projection[c];
-
-				//If there's a white pixel on the foreground image at the projection point, add the camera
-				if (m_cameras[c]->getForegroundImage().at<uchar>(point) == 255) ++camera_counter;
-
-				Mat frame = m_cameras[c]->getFrame();
-				//voxel->color = Sc
-				//cvtColor(frame.clone(), rgb_image, CV_BGR2RGB);
-				Vec3b& color_point = frame.at<Vec3b>(point);
-
-				//voxel->color = Scalar(color_point.val[0], color_point.val[1], color_point.val[2], 1);
+				spans[y][0] = min(spans[y][0], first);
+				spans[y][1] = max(spans[y][1], last);
 			}
 		}
 
-		// If the voxel is present on all cameras
-		if (camera_counter == m_cameras.size())
+		m_cameras[c]->setRoiSpans(spans);
+	}
+
+	for (size_t c = 0; c < m_cameras.size(); ++c)
+	{
+		const vector<Vec2i> &spans = m_cameras[c]->getRoiSpans();
+		size_t pixels = 0;
+		for (size_t y = 0; y < spans.size(); ++y)
+			pixels += max(spans[y][1] - spans[y][0] + 1, 0);
+		cout << "Camera " << c + 1 << " segments " << cvRound(100.0 * pixels / m_mask_size.area()) << "% of its pixels" << endl;
+	}
+}
+
+/**
+ * Count the votes of the cameras each voxel in the space appears on as
+ * foreground, if there are at least m_min_votes, add that voxel to the
+ * visible_voxels vector (by default every camera has one vote and all
+ * of them are needed)
+ * The floor vector receives the amount of visible voxels in every (x, y) column
+ *
+ * The voxels are done in blocks: per block the cameras are added one by one
+ * to a counter per voxel, a branch free loop of bit tests over the pixel LUT
+ *
+ * Doesn't touch any member, so different frames can be carved concurrently
+ */
+void Reconstructor::carve(
+		const vector<BitMask> &foregrounds, vector<Voxel*> &visible_voxels, vector<int> &floor) const
+{
+	assert(foregrounds.size() == m_cameras.size());
+	visible_voxels.clear();
+	floor.assign(m_floor_size.area(), 0);
+
+	const int block_size = 4096;  // Voxels per block, the counters stay in the L1 cache
+	const int blocks = ((int) m_voxels_amount + block_size - 1) / block_size;
+
+	int b;
+#pragma omp parallel for schedule(static) private(b) shared(visible_voxels, floor)
+	for (b = 0; b < blocks; ++b)
+	{
+		const int first = b * block_size;
+		const int count = min(block_size, (int) m_voxels_amount - first);
+
+		uchar counters[block_size] = { 0 };
+		for (size_t c = 0; c < foregrounds.size(); ++c)
 		{
+			assert(foregrounds[c].size() == m_mask_size);
+			const uint64_t* foreground = foregrounds[c].data();
+			const int* offsets = &m_pixel_offsets[c][first];
+			const uchar* in_view = &m_in_view[c][first];
+			const uchar votes = m_votes[c];
+
+			for (int i = 0; i < count; ++i)
+				counters[i] += (uchar) ((BitMask::test(foreground, offsets[i]) & in_view[i]) * votes);
+		}
+
+		vector<Voxel*> block_voxels;
+		for (int i = 0; i < count; ++i)
+			if (counters[i] >= m_min_votes) block_voxels.push_back(m_voxels[first + i]);
+
+		if (block_voxels.empty()) continue;
 #pragma omp critical //push_back is critical
-			visible_voxels.push_back(voxel);
+		for (size_t i = 0; i < block_voxels.size(); ++i)
+		{
+			visible_voxels.push_back(block_voxels[i]);
+			floor[block_voxels[i]->column]++;
+		}
+	}
+}
+
+/**
+ * Which voxels each camera actually sees, voxels hidden behind other voxels
+ * (another person) must not give their color
+ *
+ * Per camera, the voxels are splatted as squares of their projected size
+ * (see m_splat_spans) into a depth buffer where the closest voxel wins, a
+ * voxel is seen when it is at most one voxel behind the closest depth at its
+ * projection. The cameras run in parallel.
+ * seen receives per camera a flag per voxel (same order as voxels)
+ */
+void Reconstructor::visibility(
+		const vector<Voxel*> &voxels, vector<vector<uchar>> &seen) const
+{
+	seen.resize(m_cameras.size());
+
+	int c;
+#pragma omp parallel for schedule(static) private(c) shared(seen)
+	for (c = 0; c < (int) m_cameras.size(); ++c)
+	{
+		const Point3f &eye = m_cameras[c]->getCameraLocation();
+		Mat depth(m_plane_size, CV_32F, Scalar::all(FLT_MAX));
+		vector<float> distances(voxels.size(), -1);
+
+		for (size_t v = 0; v < voxels.size(); ++v)
+		{
+			const Voxel* voxel = voxels[v];
+			if (!voxel->valid_camera_projection[c]) continue;
+
+			const float dx = voxel->x - eye.x, dy = voxel->y - eye.y, dz = voxel->z - eye.z;
+			const float distance = sqrt(dx * dx + dy * dy + dz * dz);
+			distances[v] = distance;
+
+			const Point &point = voxel->camera_projection[c];
+			const int radius = max(cvCeil(m_splat_spans[c] / (2 * distance)), 1);
+			const int top = max(point.y - radius, 0), bottom = min(point.y + radius, m_plane_size.height - 1);
+			const int left = max(point.x - radius, 0), right = min(point.x + radius, m_plane_size.width - 1);
+			for (int y = top; y <= bottom; ++y)
+			{
+				float* row = depth.ptr<float>(y);
+				for (int x = left; x <= right; ++x)
+					if (distance < row[x]) row[x] = distance;
+			}
+		}
+
+		seen[c].assign(voxels.size(), 0);
+		for (size_t v = 0; v < voxels.size(); ++v)
+		{
+			if (distances[v] < 0) continue;
+			seen[c][v] = distances[v] <= depth.at<float>(voxels[v]->camera_projection[c]) + m_step;
 		}
 	}
+}
 
-	m_visible_voxels.insert(m_visible_voxels.end(), visible_voxels.begin(), visible_voxels.end());
+/**
+ * Photo-consistency refinement of a silhouette carved hull
+ *
+ * A surface voxel (seen by a camera, see visibility()) that really lies on
+ * a person has about the same color in every camera that sees it, phantom
+ * voxels between people show different things in every camera. Surface
+ * voxels seen by at least two cameras with a color standard deviation above
+ * the threshold are removed. Removing them exposes the voxels behind them,
+ * so every sweep peels one layer, for at most m_photo_sweeps sweeps.
+ *
+ * frames are the BGR camera images, floor the visible voxel counts per floor
+ * column (see carve()), both voxels and floor are updated
+ */
+void Reconstructor::refine(
+		const vector<Mat> &frames, vector<Voxel*> &voxels, vector<int> &floor) const
+{
+	assert(frames.size() == m_cameras.size());
+	const double max_variance = m_photo_threshold * m_photo_threshold;
+
+	vector<vector<uchar>> seen;
+	vector<uchar> inconsistent;
+	for (int sweep = 0; sweep < m_photo_sweeps; ++sweep)
+	{
+		visibility(voxels, seen);
+		inconsistent.assign(voxels.size(), 0);
+
+		int v;
+#pragma omp parallel for schedule(static) private(v) shared(inconsistent)
+		for (v = 0; v < (int) voxels.size(); ++v)
+		{
+			const Voxel* voxel = voxels[v];
+			double sum[3] = { 0, 0, 0 }, sum_sq[3] = { 0, 0, 0 };
+			int count = 0;
+			for (size_t c = 0; c < frames.size(); ++c)
+			{
+				if (!seen[c][v]) continue;
+
+				const Vec3b &pixel = frames[c].at<Vec3b>(voxel->camera_projection[c]);
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					sum[channel] += pixel[channel];
+					sum_sq[channel] += pixel[channel] * pixel[channel];
+				}
+				count++;
+			}
+			if (count < 2) continue;
+
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				const double mean = sum[channel] / count;
+				if (sum_sq[channel] / count - mean * mean > max_variance) inconsistent[v] = 1;
+			}
+		}
+
+		// Remove them, keeping the order of the others
+		size_t kept = 0;
+		for (size_t i = 0; i < voxels.size(); ++i)
+		{
+			if (inconsistent[i])
+				floor[voxels[i]->column]--;
+			else
+				voxels[kept++] = voxels[i];
+		}
+		if (kept == voxels.size()) break;
+		voxels.resize(kept);
+	}
+}
+
+/**
+ * Color of every visible voxel: the mean of the pixels it projects on in the
+ * cameras that see it (see visibility()), or in all cameras if none does
+ * frames are the BGR camera images, colors receives packed RGB per voxel
+ * (same order as voxels, ready for glColor3ubv)
+ */
+void Reconstructor::color(
+		const vector<Mat> &frames, const vector<Voxel*> &voxels, const vector<vector<uchar>> &seen,
+		vector<Vec3b> &colors) const
+{
+	assert(frames.size() == m_cameras.size() && seen.size() == m_cameras.size());
+	colors.resize(voxels.size());
+
+	int v;
+#pragma omp parallel for schedule(static) private(v) shared(colors)
+	for (v = 0; v < (int) voxels.size(); ++v)
+	{
+		const Voxel* voxel = voxels[v];
+		int sum[3] = { 0, 0, 0 };
+		int count = 0;
+
+		// First the cameras that see the voxel, then (occluded voxels) all cameras
+		for (int pass = 0; pass < 2 && count == 0; ++pass)
+		{
+			for (size_t c = 0; c < frames.size(); ++c)
+			{
+				if (!voxel->valid_camera_projection[c] || (pass == 0 && !seen[c][v])) continue;
+
+				const Vec3b &pixel = frames[c].at<Vec3b>(voxel->camera_projection[c]);
+				sum[0] += pixel[0];
+				sum[1] += pixel[1];
+				sum[2] += pixel[2];
+				count++;
+			}
+		}
+
+		if (count == 0)
+			colors[v] = Vec3b(0, 0, 0);
+		else
+			colors[v] = Vec3b((uchar) (sum[2] / count), (uchar) (sum[1] / count), (uchar) (sum[0] / count));
+	}
 }
 
 } /* namespace nl_uu_science_gmt */
@@ -10,6 +10,7 @@
 
 #include <opencv2/core/core.hpp>
 #include <stddef.h>
+#include <algorithm>
 #include <vector>
 #include <map>
 
@@ -28,6 +29,8 @@ public:
 	struct Voxel
 	{
 		int x, y, z;                               // Coordinates
+		int column;                                // Index of the voxel's (x, y) column on the floor grid
+		int index;                                 // Index of the voxel in the voxel LUT (layer * floor area + column)
 		cv::Scalar color;                          // Color
 		std::vector<cv::Point> camera_projection;  // Projection location for camera[c]'s FoV (2D)
 		std::vector<int> valid_camera_projection;  // Flag if camera projection is in camera[c]'s FoV
@@ -37,6 +40,13 @@ private:
 	const std::vector<Camera*> &m_cameras;  // vector of pointers to cameras
 	const int m_height;                     // Cube half-space height from floor to ceiling
 	const int m_step;                       // Step size (space between voxels)
+	std::vector<float> m_splat_spans;       // Per camera, projected voxel size (pixels) times its distance (mm), sizes its square in the visibility depth buffer
+	int m_photo_sweeps;                     // Photo-consistency passes, each one peels at most one surface layer
+	double m_photo_threshold;               // Largest color standard deviation (per channel) between cameras of a consistent voxel
+	const int m_roi_margin;                 // Mask pixels around the voxel projections that are segmented (reach of the mask cleanup)
+	const int m_max_mask_scale;             // Largest reduction of the segmentation resolution (1: full resolution)
+	int m_mask_scale;                       // Frames are segmented at 1 / m_mask_scale of their size
+	cv::Size m_mask_size;                   // Foreground mask WxH
 
 	std::vector<cv::Point3f*> m_corners;    // Cube half-space corner locations
 
@@ -44,27 +54,43 @@ private:
 
 	size_t m_voxels_amount;                 // Voxel count
 	cv::Size m_plane_size;                  // Camera FoV plane WxH
+	cv::Size m_floor_size;                  // Floor grid WxH (voxel columns)
 
 	std::vector<Voxel*> m_voxels;           // Pointer vector to all voxels in the half-space
-	std::vector<Voxel*> m_visible_voxels;   // Pointer vector to all visible voxels
+	std::vector<std::vector<int>> m_pixel_offsets;  // Per camera, foreground mask bit (y * BitMask::rowBits(mask width) + x) of every voxel's projection (0 if not in the FoV)
+	std::vector<std::vector<uchar>> m_in_view;      // Per camera, 1 for every voxel projecting in the FoV, else 0
+	std::vector<uchar> m_votes;             // Per camera, votes a foreground projection counts for (confidence in its mask)
+	int m_min_votes;                        // Votes a voxel needs to be kept (k of n carving)
 
 	// List of clusters with a tuple of scalar hist and secondly a list of voxel points
 	//std::map<cv::Point2f, std::vector<cv::Point2f>> m_clustered_visible_voxels;
 	void initialize();
+	void createRoiSpans();
+	double footprint(
+			size_t, const cv::Point3f &) const;
+	int chooseMaskScale() const;
 
 public:
 	Reconstructor(
-			const std::vector<Camera*> &);
+			const std::vector<Camera*> &, int = 1);
 	virtual ~Reconstructor();
 
 
 	//cv::Mat updateColorModel();
 
-	void update();
-
-	const std::vector<Voxel*>& getVisibleVoxels() const
+	void carve(
+			const std::vector<BitMask> &, std::vector<Voxel*> &, std::vector<int> &) const;
+	void visibility(
+			const std::vector<Voxel*> &, std::vector<std::vector<uchar>> &) const;
+	void color(
+			const std::vector<cv::Mat> &, const std::vector<Voxel*> &, const std::vector<std::vector<uchar>> &,
+			std::vector<cv::Vec3b> &) const;
+	void refine(
+			const std::vector<cv::Mat> &, std::vector<Voxel*> &, std::vector<int> &) const;
+
+	const cv::Size& getFloorSize() const
 	{
-		return m_visible_voxels;
+		return m_floor_size;
 	}
 
 	const std::vector<Voxel*>& getVoxels() const
@@ -72,12 +98,6 @@ public:
 		return m_voxels;
 	}
 
-	void setVisibleVoxels(
-			const std::vector<Voxel*>& visibleVoxels)
-	{
-		m_visible_voxels = visibleVoxels;
-	}
-
 	void setVoxels(
 			const std::vector<Voxel*>& voxels)
 	{
@@ -94,6 +114,76 @@ public:
 		return m_height;
 	}
 
+	int getStep() const
+	{
+		return m_step;
+	}
+
+	int getMaskScale() const
+	{
+		return m_mask_scale;
+	}
+
+	/**
+	 * Foreground mask pixel of a camera pixel
+	 */
+	cv::Point toMask(
+			const cv::Point &point) const
+	{
+		return cv::Point((std::min)(point.x / m_mask_scale, m_mask_size.width - 1), (std::min)(point.y / m_mask_scale, m_mask_size.height - 1));
+	}
+
+	const std::vector<uchar>& getVotes() const
+	{
+		return m_votes;
+	}
+
+	/**
+	 * Confidence in camera c's foreground mask, 0 ignores the camera
+	 * The votes of all cameras add up in 8 bit counters, so a camera gets at most 255 / cameras
+	 */
+	void setVotes(
+			size_t c, int votes)
+	{
+		m_votes.at(c) = (uchar) (std::min)((std::max)(votes, 0), 255 / (int) m_votes.size());
+	}
+
+	int getMinVotes() const
+	{
+		return m_min_votes;
+	}
+
+	/**
+	 * k of n carving: a voxel is kept when it's foreground in cameras worth at least this many votes
+	 */
+	void setMinVotes(
+			int minVotes)
+	{
+		m_min_votes = (std::max)(minVotes, 1);
+	}
+
+	int getPhotoSweeps() const
+	{
+		return m_photo_sweeps;
+	}
+
+	void setPhotoSweeps(
+			int photoSweeps)
+	{
+		m_photo_sweeps = photoSweeps;
+	}
+
+	double getPhotoThreshold() const
+	{
+		return m_photo_threshold;
+	}
+
+	void setPhotoThreshold(
+			double photoThreshold)
+	{
+		m_photo_threshold = photoThreshold;
+	}
+
 	const cv::Size& getPlaneSize() const
 	{
 		return m_plane_size;
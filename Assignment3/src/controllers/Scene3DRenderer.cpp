@@ -13,6 +13,7 @@
 #include <opencv2/imgproc/types_c.h>
 #include <stddef.h>
 #include <string>
+#include <thread>
 #include <opencv2/features2d.hpp>
 #include "../utilities/General.h"
 
@@ -46,6 +47,13 @@ namespace nl_uu_science_gmt
 		m_show_arcball = false;
 		m_show_info = true;
 		m_fullscreen = false;
+		m_adapt_background = true;
+		m_background_rate = 0.005f;
+		m_foreground_epoch = 0;
+
+		// The structuring elements of the foreground cleanup, built once
+		m_noise_element = BitMask::Element(getStructuringElement(MORPH_ELLIPSE, Size(2, 2)));
+		m_hole_element = BitMask::Element(getStructuringElement(MORPH_ELLIPSE, Size(5, 5)));
 
 		// Read the checkerboard properties (XML)
 		FileStorage fs;
@@ -65,21 +73,8 @@ namespace nl_uu_science_gmt
 		m_current_frame = 0;
 		m_previous_frame = -1;
 
-		const int max = 255;
-		const int H = 0;
-		const int S = 0;
-		const int V = 0;
-		m_h_threshold = H;
-		m_ph_threshold = H;
-		m_s_threshold = S;
-		m_ps_threshold = S;
-		m_v_threshold = V;
-		m_pv_threshold = V;
-
+		// The segmentation thresholds come from the background models (see BackgroundModel)
 		createTrackbar("Frame", VIDEO_WINDOW, &m_current_frame, m_number_of_frames - 2);
-		createTrackbar("H", VIDEO_WINDOW, &m_h_threshold, max);
-		createTrackbar("S", VIDEO_WINDOW, &m_s_threshold, max);
-		createTrackbar("V", VIDEO_WINDOW, &m_v_threshold, max);
 
 		createFloorGrid();
 		setTopView();
@@ -97,40 +92,141 @@ namespace nl_uu_science_gmt
 	}
 
 	/**
-	 * Process the current frame on each camera
+	 * Separate the background from the foreground of several cameras at once
+	 *
+	 * The masks are split in horizontal bands (of whole change detection tiles) and
+	 * every step is one parallel loop over all (camera, band) pairs, so one high
+	 * resolution camera keeps all cores busy as well as several small ones:
+	 * 	- scale the frame down (a band of mask rows is a band of frame rows)
+	 * 	- find the changed tiles (per camera)
+	 * 	- convert and subtract the changed tiles of every band
+	 * 	- clean every band of the mask, with halo rows around it for the reach of
+	 * 	  the morphology, so the bands give exactly the same mask as a whole
+	 *
+	 * With a learned model only the tiles that changed since they were last segmented
+	 * are done again (see ChangeDetector), plus a rotating share of the unchanged
+	 * tiles so the adapting models follow slow lighting changes as well,
+	 * skipped receives the fraction of tiles skipped
+	 * per camera. Without a model the global thresholds are used (per camera).
+	 *
+	 * Only touches the cameras' background models (a learned model adapts to the
+	 * frame's background pixels) and change detectors, the frames of one camera must
+	 * be segmented one after the other (see Pipeline)
 	 */
-	bool Scene3DRenderer::processFrame()
+	void Scene3DRenderer::processForegrounds(
+		const vector<Camera*>& cameras, const vector<Mat>& frames, vector<BitMask>& foregrounds, vector<float>& skipped) const
 	{
-		for (size_t c = 0; c < m_cameras.size(); ++c)
+		assert(frames.size() == cameras.size());
+		const int n = (int) cameras.size();
+		foregrounds.resize(n);
+		skipped.assign(n, 0.f);
+
+		// Enough bands per camera to keep every core busy
+		const int cores = max((int) thread::hardware_concurrency(), 1);
+		vector<Vec4i> bands;  // Camera, first row, end row, band of the camera
+		vector<Mat> images(n), model_images(n);
+		for (int c = 0; c < n; ++c)
 		{
-			if (m_current_frame == m_previous_frame + 1)
+			assert(!frames[c].empty());
+			const Size size = cameras[c]->getMaskSize();
+			const int tile_height = cameras[c]->getChangeDetector().getTileHeight();
+			const int tile_rows = (size.height + tile_height - 1) / tile_height;
+			const int band_count = min((cores + n - 1) / n, tile_rows);
+			const int band_height = (tile_rows + band_count - 1) / band_count * tile_height;
+			int band = 0;
+			for (int first = 0; first < size.height; first += band_height)
+				bands.push_back(Vec4i(c, first, min(first + band_height, size.height), band++));
+
+			// Every band cleans its rows with its own working memory, kept from frame to frame
+			vector<BitMask::Scratch>& scratch = cameras[c]->getChangeDetector().getScratch();
+			if ((int) scratch.size() < max(band, 1)) scratch.resize(max(band, 1));
+
+			images[c] = cameras[c]->getMaskScale() > 1 ? Mat(size, CV_8UC3) : frames[c];
+		}
+
+		int b;
+#pragma omp parallel for schedule(dynamic) private(b)
+		for (b = 0; b < (int) bands.size(); ++b)
+		{
+			const int c = bands[b][0], scale = cameras[c]->getMaskScale();
+			if (scale == 1) continue;
+
+			// Whole blocks of scale x scale frame pixels, each is averaged into one pixel
+			const Rect block(0, bands[b][1] * scale, images[c].cols * scale, (bands[b][2] - bands[b][1]) * scale);
+			Mat band = images[c].rowRange(bands[b][1], bands[b][2]);
+			resize(frames[c](block), band, band.size(), 0, 0, INTER_AREA);
+		}
+
+		int c;
+#pragma omp parallel for schedule(static) private(c)
+		for (c = 0; c < n; ++c)
+		{
+			if (cameras[c]->getBackgroundModel().empty())
 			{
-				m_cameras[c]->advanceVideoFrame();
+				processGlobalForeground(cameras[c], images[c], foregrounds[c], cameras[c]->getChangeDetector().getScratch()[0]);
+				continue;
 			}
-			else if (m_current_frame != m_previous_frame)
+
+			skipped[c] = cameras[c]->getChangeDetector().detect(images[c], cameras[c]->getRoiSpans());
+			model_images[c].create(images[c].size(), CV_8UC3);
+			foregrounds[c].create(images[c].rows, images[c].cols);
+		}
+
+		// Per pixel thresholds of a learned background model are tight enough to skip the noise removal
+		// Only the changed tiles carving can depend on are converted (to the model's color space) and segmented
+		const float rate = m_adapt_background ? m_background_rate.load() : 0.f;
+#pragma omp parallel for schedule(dynamic) private(b)
+		for (b = 0; b < (int) bands.size(); ++b)
+		{
+			const int c = bands[b][0];
+			BackgroundModel& model = cameras[c]->getBackgroundModel();
+			if (model.empty()) continue;
+
+			ChangeDetector& detector = cameras[c]->getChangeDetector();
+			const vector<Rect>* tiles[2] = { &detector.getChanged(), &detector.getRefreshed() };
+			vector<Rect> band_tiles[2];
+			for (int k = 0; k < 2; ++k)
 			{
-				m_cameras[c]->getVideoFrame(m_current_frame);
+				for (size_t t = 0; t < tiles[k]->size(); ++t)
+				{
+					const Rect& tile = (*tiles[k])[t];
+					if (tile.y < bands[b][1] || tile.y >= bands[b][2]) continue;
+					band_tiles[k].push_back(tile);
+					Mat model_tile = model_images[c](tile);
+					cvtColor(images[c](tile), model_tile, model.getConversion());
+				}
 			}
-			assert(m_cameras[c] != NULL);
-			processForeground(m_cameras[c]);
+
+			// The bands are disjoint rows of the model and the mask
+			// A refreshed tile is only learned from once per refresh interval, at as much more weight
+			const float refresh_rate = min(rate * max(detector.getRefreshInterval(), 1), 1.f);
+			model.subtract(model_images[c], cameras[c]->getRoiSpans(), band_tiles[0], detector.getMask(), rate);
+			model.subtract(model_images[c], cameras[c]->getRoiSpans(), band_tiles[1], detector.getMask(), refresh_rate);
+		}
+
+#pragma omp parallel for schedule(dynamic) private(b)
+		for (b = 0; b < (int) bands.size(); ++b)
+		{
+			const int c = bands[b][0];
+			if (cameras[c]->getBackgroundModel().empty()) continue;
+			ChangeDetector& detector = cameras[c]->getChangeDetector();
+			cleanForeground(detector.getMask(), foregrounds[c], bands[b][1], bands[b][2], false, detector.getScratch()[bands[b][3]]);
 		}
-		return true;
 	}
 
 	/**
-	 * Separate the background from the foreground
-	 * ie.: Create an 8 bit image where only the foreground of the scene is white (255)
+	 * Segmentation without a learned model: per channel one threshold for the whole
+	 * image, from the standard deviation of its difference with the background image
 	 */
-	void Scene3DRenderer::processForeground(
-		Camera* camera)
+	void Scene3DRenderer::processGlobalForeground(
+		const Camera* camera, const Mat& image, BitMask& foreground, BitMask::Scratch& scratch) const
 	{
-		assert(!camera->getFrame().empty());
-		int max = 255;
-		Mat image, hsv_image, tmp, foreground, background;
+		const int max = 255;
+		Mat hsv_image, tmp, background, foreground_image;
+		int h_threshold, s_threshold, v_threshold;
 
-		image = camera->getFrame();
 		// from BGR to HSV color space
-		cvtColor(image.clone(), hsv_image, CV_BGR2HSV);
+		cvtColor(image, hsv_image, CV_BGR2HSV);
 
 		vector<Mat> image_channels, camera_channels;
 		// Split the HSV-channels for further analysis
@@ -141,46 +237,58 @@ namespace nl_uu_science_gmt
 		absdiff(image_channels.at(0), camera_channels.at(0), tmp);
 		// Compute standard deviation of camera channel 1, to find idial h_threshold
 		meanStdDev(tmp, mean, m_h_stddev);
-		m_h_threshold = m_h_stddev[0];
+		h_threshold = (int) m_h_stddev[0];
 
 		//findContours(m_h_stddev, .RETR_TREE, cv2.CHAIN_APPROX_SIMPLE)
 		//drawContours(image, contours, -1, (100, 0, 255), 2)
 
 		// Apply new threshold
-		threshold(tmp, foreground, m_h_threshold, max, CV_THRESH_BINARY);
+		threshold(tmp, foreground_image, h_threshold, max, CV_THRESH_BINARY);
 		// Background subtraction S
 		absdiff(image_channels.at(1), camera_channels.at(1), tmp);
 
 		// Compute standard deviation of camera channel 1, to find idial s_threshold
 		meanStdDev(tmp, mean, m_s_stddev);
-		m_s_threshold = m_s_stddev[0];
+		s_threshold = (int) m_s_stddev[0];
 		// Apply new threshold
-		threshold(tmp, background, m_s_threshold, max, CV_THRESH_BINARY);
-		bitwise_and(foreground, background, foreground);
+		threshold(tmp, background, s_threshold, max, CV_THRESH_BINARY);
+		bitwise_and(foreground_image, background, foreground_image);
 
 		// Background subtraction V
 		absdiff(image_channels.at(2), camera_channels.at(2), tmp);
 		// Compute standard deviation of camera channel 1, to find idial v_threshold
 		meanStdDev(tmp, mean, m_v_stddev);
-		m_v_threshold = (m_v_stddev[0] * 2); // Times 2 for shadow removement
+		v_threshold = (int) (m_v_stddev[0] * 2); // Times 2 for shadow removement
 		// Apply new threshold
-		threshold(tmp, background, m_v_threshold, max, CV_THRESH_BINARY);
-		bitwise_or(foreground, background, foreground);
+		threshold(tmp, background, v_threshold, max, CV_THRESH_BINARY);
+		bitwise_or(foreground_image, background, foreground_image);
 
-		// Detecting noice
-		Mat structured_elements_2 = getStructuringElement(MORPH_ELLIPSE, Size(2, 2));
-		Mat structured_elements_5 = getStructuringElement(MORPH_ELLIPSE, Size(5, 5));
-
-		// Remove small detected noice
-		erode(foreground, foreground, structured_elements_2);
-		dilate(foreground, foreground, structured_elements_2);
-
-		// Remove large detected noice
-		dilate(foreground, foreground, structured_elements_5);
-		erode(foreground, foreground, structured_elements_5);
+		BitMask raw;
+		raw.fromMat(foreground_image);
+		foreground.create(raw.rows(), raw.cols());
+		cleanForeground(raw, foreground, 0, raw.rows(), true, scratch);
+	}
 
-		// Improve the foreground image
-		camera->setForegroundImage(foreground);
+	/**
+	 * Remove small noise (opening, optional) and close the holes in the silhouettes,
+	 * rows first to last (exclusive) of src into the same rows of dst
+	 * Both operations run on the packed mask, 64 pixels at a time. The rows they
+	 * reach above and below the band are included, so bands can be done apart
+	 * All intermediate masks are in scratch, so this allocates nothing once
+	 * scratch has been used for a band this size
+	 */
+	void Scene3DRenderer::cleanForeground(
+		const BitMask& src, BitMask& dst, int first, int last, bool remove_noise, BitMask::Scratch& scratch) const
+	{
+		const int halo = 2 * m_hole_element.reach() + (remove_noise ? 2 * m_noise_element.reach() : 0);
+		const int top = max(first - halo, 0), bottom = min(last + halo, src.rows());
+
+		BitMask& band = scratch.band;
+		band.create(bottom - top, src.cols());
+		src.copyRows(top, bottom - top, band, 0);
+		if (remove_noise) BitMask::open(band, band, m_noise_element, scratch);
+		BitMask::close(band, band, m_hole_element, scratch);
+		band.copyRows(first - top, last - first, dst, first);
 	}
 
 	/**
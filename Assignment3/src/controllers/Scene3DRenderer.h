@@ -10,6 +10,7 @@
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/core/operations.hpp>
+#include <atomic>
 #include <vector>
 #ifdef _WIN32
 #include <Windows.h>
@@ -18,6 +19,7 @@
 #include "arcball.h"
 #include "Camera.h"
 #include "Reconstructor.h"
+#include "../utilities/BitMask.h"
 
 namespace nl_uu_science_gmt
 {
@@ -63,17 +65,21 @@ class Scene3DRenderer
 	int m_current_camera;                     // number of currently selected camera view point
 	int m_previous_camera;                    // number of previously selected camera view point
 
-	int m_h_threshold;                        // Hue threshold number for background subtraction
-	int m_ph_threshold;                       // Hue threshold value at previous iteration (update awareness)
-	int m_s_threshold;                        // Saturation threshold number for background subtraction
-	int m_ps_threshold;                       // Saturation threshold value at previous iteration (update awareness)
-	int m_v_threshold;                        // Value threshold number for background subtraction
-	int m_pv_threshold;                       // Value threshold value at previous iteration (update awareness)
+	std::atomic<bool> m_adapt_background;     // flag segmentation updates the background models
+	std::atomic<float> m_background_rate;     // Weight of a new frame in the background models
+	std::atomic<unsigned> m_foreground_epoch;  // Changes with the segmentation settings (see FrameCache)
+
+	BitMask::Element m_noise_element;         // 2x2 ellipse, opening removes small noise
+	BitMask::Element m_hole_element;          // 5x5 ellipse, closing fills holes in the silhouettes
 
 	// edge points of the virtual ground floor grid
 	std::vector<std::vector<cv::Point3i*> > m_floor_grid;
 
 	void createFloorGrid();
+	void processGlobalForeground(
+			const Camera*, const cv::Mat &, BitMask &, BitMask::Scratch &) const;
+	void cleanForeground(
+			const BitMask &, BitMask &, int, int, bool, BitMask::Scratch &) const;
 
 #ifdef _WIN32
 	HDC _hDC;
@@ -84,10 +90,9 @@ public:
 			Reconstructor &, const std::vector<Camera*> &);
 	virtual ~Scene3DRenderer();
 
-	void processForeground(
-			Camera*);
+	void processForegrounds(
+			const std::vector<Camera*> &, const std::vector<cv::Mat> &, std::vector<BitMask> &, std::vector<float> &) const;
 
-	bool processFrame();
 	void setCamera(
 			int);
 	void setTopView();
@@ -108,6 +113,41 @@ public:
 		m_camera_view = cameraView;
 	}
 
+	bool isAdaptBackground() const
+	{
+		return m_adapt_background;
+	}
+
+	void setAdaptBackground(
+			bool adaptBackground)
+	{
+		m_adapt_background = adaptBackground;
+		++m_foreground_epoch;
+	}
+
+	float getBackgroundRate() const
+	{
+		return m_background_rate;
+	}
+
+	void setBackgroundRate(
+			float backgroundRate)
+	{
+		m_background_rate = backgroundRate;
+		++m_foreground_epoch;
+	}
+
+	/**
+	 * Masks cached in an older epoch were made with other segmentation settings
+	 * A setter changes its setting before the epoch, see Pipeline::segment()
+	 * The slow adaptation of the background models doesn't start a new epoch,
+	 * a cached mask may be a little behind the models
+	 */
+	unsigned getForegroundEpoch() const
+	{
+		return m_foreground_epoch;
+	}
+
 	int getCurrentCamera() const
 	{
 		return m_current_camera;
@@ -337,72 +377,6 @@ public:
 		return m_previous_camera;
 	}
 
-	int getHThreshold() const
-	{
-		return m_h_threshold;
-	}
-
-	int getSThreshold() const
-	{
-		return m_s_threshold;
-	}
-
-	int getVThreshold() const
-	{
-		return m_v_threshold;
-	}
-
-	int getPHThreshold() const
-	{
-		return m_ph_threshold;
-	}
-
-	int getPSThreshold() const
-	{
-		return m_ps_threshold;
-	}
-
-	int getPVThreshold() const
-	{
-		return m_pv_threshold;
-	}
-
-	void setPHThreshold(
-			int phThreshold)
-	{
-		m_ph_threshold = phThreshold;
-	}
-
-	void setPSThreshold(
-			int psThreshold)
-	{
-		m_ps_threshold = psThreshold;
-	}
-
-	void setPVThreshold(
-			int pvThreshold)
-	{
-		m_pv_threshold = pvThreshold;
-	}
-
-	void setHThreshold(
-			int threshold)
-	{
-		m_h_threshold = threshold;
-	}
-
-	void setSThreshold(
-			int threshold)
-	{
-		m_s_threshold = threshold;
-	}
-
-	void setVThreshold(
-			int threshold)
-	{
-		m_v_threshold = threshold;
-	}
-
 	const cv::Size& getBoardSize() const
 	{
 		return m_board_size;
@@ -0,0 +1,215 @@
+/*
+ * Tracker.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "Tracker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Constructor
+ * gate: distance (mm) equal in cost to a completely different color
+ * ambiguity: margin (mm) within which a second cluster makes a track ambiguous
+ */
+Tracker::Tracker(
+		float gate, float ambiguity) :
+				m_gate(gate),
+				m_ambiguity(ambiguity),
+				m_velocity_rate(0.5f),
+				m_model_rate(0.05f)
+{
+}
+
+Tracker::~Tracker()
+{
+}
+
+/**
+ * Start a track per cluster, person i is cluster i
+ */
+void Tracker::initialize(
+		const vector<Point2f> &centers, const vector<ColorSignature> &signatures)
+{
+	assert(centers.size() == signatures.size());
+
+	m_tracks.resize(centers.size());
+	for (size_t i = 0; i < centers.size(); ++i)
+	{
+		m_tracks[i].id = (int) i;
+		m_tracks[i].position = centers[i];
+		m_tracks[i].velocity = Point2f(0, 0);
+		m_tracks[i].model = signatures[i];
+	}
+}
+
+/**
+ * Assign the clusters of a new frame to the tracks and move the tracks along
+ *
+ * centers: floor position per cluster
+ * signature: computes the color signature of a cluster, only called when tracks are ambiguous
+ * identities: receives the person per cluster (-1 if there are more clusters than tracks)
+ *
+ * Returns true if colors had to be compared
+ */
+bool Tracker::update(
+		const vector<Point2f> &centers, const Signature &signature, vector<int> &identities)
+{
+	identities.assign(centers.size(), -1);
+	if (m_tracks.empty() || centers.empty()) return false;
+
+	const size_t tracks = m_tracks.size();
+
+	vector<Point2f> predicted(tracks);
+	for (size_t t = 0; t < tracks; ++t)
+		predicted[t] = m_tracks[t].position + m_tracks[t].velocity;
+
+	vector<vector<float>> distances(tracks, vector<float>(centers.size()));
+	vector<vector<double>> cost(tracks, vector<double>(centers.size()));
+	for (size_t t = 0; t < tracks; ++t)
+	{
+		for (size_t c = 0; c < centers.size(); ++c)
+		{
+			const Point2f d = centers[c] - predicted[t];
+			distances[t][c] = sqrt(d.x * d.x + d.y * d.y);
+			cost[t][c] = distances[t][c] / m_gate;
+		}
+	}
+
+	vector<int> assignment;
+	solve(cost, assignment);
+
+	// Ambiguous: some other cluster is almost as close to the prediction as the assigned one
+	bool ambiguous = false;
+	for (size_t t = 0; t < tracks && !ambiguous; ++t)
+	{
+		if (assignment[t] < 0) continue;
+		for (size_t c = 0; c < centers.size() && !ambiguous; ++c)
+			ambiguous = (int) c != assignment[t] && distances[t][c] - distances[t][assignment[t]] < m_ambiguity;
+	}
+
+	vector<ColorSignature> signatures;
+	if (ambiguous)
+	{
+		signatures.resize(centers.size());
+		for (size_t c = 0; c < centers.size(); ++c)
+			signatures[c] = signature((int) c);
+
+		for (size_t t = 0; t < tracks; ++t)
+		{
+			for (size_t c = 0; c < centers.size(); ++c)
+			{
+				// Correlation 1 costs nothing, -1 as much as the gate distance
+				cost[t][c] += m_tracks[t].model.distance(signatures[c]) / 2;
+			}
+		}
+		solve(cost, assignment);
+	}
+
+	for (size_t t = 0; t < tracks; ++t)
+	{
+		Track &track = m_tracks[t];
+		const int c = assignment[t];
+		if (c < 0)
+		{
+			// No cluster left for this person, coast along
+			track.position = predicted[t];
+			track.velocity *= 1 - m_velocity_rate;
+			continue;
+		}
+
+		identities[c] = track.id;
+		track.velocity = track.velocity * (1 - m_velocity_rate) + (centers[c] - track.position) * m_velocity_rate;
+		track.position = centers[c];
+		if (ambiguous) track.model.blend(signatures[c], m_model_rate);
+	}
+
+	return ambiguous;
+}
+
+/**
+ * Minimum cost assignment of rows to columns (Hungarian method, O(n^3))
+ * assignment receives the column per row, -1 for rows left over when there
+ * are more rows than columns
+ */
+void Tracker::solve(
+		const vector<vector<double>> &cost, vector<int> &assignment)
+{
+	const int rows = (int) cost.size();
+	const int cols = rows > 0 ? (int) cost[0].size() : 0;
+	const int n = max(rows, cols);  // Padded to square, the padding costs nothing
+
+	// Potentials u (rows), v (columns) and the row matched to every column, all 1-based
+	vector<double> u(n + 1, 0), v(n + 1, 0);
+	vector<int> match(n + 1, 0), way(n + 1, 0);
+
+	for (int i = 1; i <= n; ++i)
+	{
+		match[0] = i;
+		int j0 = 0;
+		vector<double> min_v(n + 1, DBL_MAX);
+		vector<bool> used(n + 1, false);
+		do
+		{
+			used[j0] = true;
+			const int i0 = match[j0];
+			double delta = DBL_MAX;
+			int j1 = 0;
+			for (int j = 1; j <= n; ++j)
+			{
+				if (used[j]) continue;
+				const double c = i0 <= rows && j <= cols ? cost[i0 - 1][j - 1] : 0;
+				const double reduced = c - u[i0] - v[j];
+				if (reduced < min_v[j])
+				{
+					min_v[j] = reduced;
+					way[j] = j0;
+				}
+				if (min_v[j] < delta)
+				{
+					delta = min_v[j];
+					j1 = j;
+				}
+			}
+			for (int j = 0; j <= n; ++j)
+			{
+				if (used[j])
+				{
+					u[match[j]] += delta;
+					v[j] -= delta;
+				}
+				else
+				{
+					min_v[j] -= delta;
+				}
+			}
+			j0 = j1;
+		}
+		while (match[j0] != 0);
+
+		do
+		{
+			const int j1 = way[j0];
+			match[j0] = match[j1];
+			j0 = j1;
+		}
+		while (j0 != 0);
+	}
+
+	assignment.assign(rows, -1);
+	for (int j = 1; j <= cols; ++j)
+		if (match[j] >= 1 && match[j] <= rows) assignment[match[j] - 1] = j - 1;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,127 @@
+/*
+ * Tracker.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef TRACKER_H_
+#define TRACKER_H_
+
+#include <opencv2/core/core.hpp>
+#include <functional>
+#include <vector>
+
+#include "../utilities/ColorSignature.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Keeps one track per person (floor position, velocity, color model) and
+ * assigns the clusters of every frame to the tracks as a whole with the
+ * Hungarian method, instead of picking the best histogram per cluster.
+ *
+ * The assignment first uses the distance to the predicted positions only.
+ * Only when a track has a second cluster nearly as close to its predicted
+ * position as its own (less than m_ambiguity further, people passing each
+ * other), the color signatures of all clusters are computed and the
+ * assignment of all tracks is solved again on position + color cost.
+ */
+class Tracker
+{
+public:
+	typedef std::function<ColorSignature(int)> Signature;  // Normalized color signature of cluster i
+
+	struct Track
+	{
+		int id;                                 // Person
+		cv::Point2f position;                   // Floor position (mm) in the last frame
+		cv::Point2f velocity;                   // Smoothed displacement per frame (mm)
+		ColorSignature model;                   // Colors of the person
+	};
+
+private:
+	std::vector<Track> m_tracks;
+
+	float m_gate;                           // Distance (mm) that costs as much as a completely different color
+	float m_ambiguity;                      // A track is ambiguous when another cluster is less than this (mm) further away
+	float m_velocity_rate;                  // Weight of the newest displacement in the velocity
+	float m_model_rate;                     // Weight of a new signature in the color model
+
+	static void solve(
+			const std::vector<std::vector<double>> &, std::vector<int> &);
+
+public:
+	Tracker(
+			float = 1000, float = 250);
+	virtual ~Tracker();
+
+	void initialize(
+			const std::vector<cv::Point2f> &, const std::vector<ColorSignature> &);
+	bool update(
+			const std::vector<cv::Point2f> &, const Signature &, std::vector<int> &);
+
+	bool isInitialized() const
+	{
+		return !m_tracks.empty();
+	}
+
+	void reset()
+	{
+		m_tracks.clear();
+	}
+
+	const std::vector<Track>& getTracks() const
+	{
+		return m_tracks;
+	}
+
+	float getGate() const
+	{
+		return m_gate;
+	}
+
+	void setGate(
+			float gate)
+	{
+		m_gate = gate;
+	}
+
+	float getAmbiguity() const
+	{
+		return m_ambiguity;
+	}
+
+	void setAmbiguity(
+			float ambiguity)
+	{
+		m_ambiguity = ambiguity;
+	}
+
+	float getVelocityRate() const
+	{
+		return m_velocity_rate;
+	}
+
+	void setVelocityRate(
+			float velocityRate)
+	{
+		m_velocity_rate = velocityRate;
+	}
+
+	float getModelRate() const
+	{
+		return m_model_rate;
+	}
+
+	void setModelRate(
+			float modelRate)
+	{
+		m_model_rate = modelRate;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* TRACKER_H_ */
@@ -0,0 +1,210 @@
+/*
+ * Trajectories.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "Trajectories.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <stdint.h>
+#include <cstring>
+#include <fstream>
+
+#include "../utilities/General.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Little endian 32 bit value
+ */
+static void write32(
+		ostream &out, uint32_t value)
+{
+	const unsigned char bytes[4] = { (unsigned char) value, (unsigned char) (value >> 8), (unsigned char) (value >> 16),
+			(unsigned char) (value >> 24) };
+	out.write((const char*) bytes, 4);
+}
+
+/**
+ * Little endian IEEE 754 single precision value
+ */
+static void writeFloat(
+		ostream &out, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	write32(out, bits);
+}
+
+/**
+ * Constructor
+ * half_size: half the width of the floor (mm), plan_size: floor plan width and height (pixels)
+ */
+Trajectories::Trajectories(
+		int half_size, int plan_size) :
+				m_half_size(half_size),
+				m_scale(plan_size / (2.0 * half_size)),
+				m_version(0)
+{
+	m_floor_plan = Mat(plan_size, plan_size, CV_8UC3);
+	drawBackground();
+}
+
+Trajectories::~Trajectories()
+{
+}
+
+/**
+ * Floor position to floor plan pixel, +y points up
+ */
+Point Trajectories::toPlan(
+		const Sample &sample) const
+{
+	return Point(cvRound((sample.x + m_half_size) * m_scale), cvRound((m_half_size - sample.y) * m_scale));
+}
+
+/**
+ * Empty floor plan with a grid line every meter
+ */
+void Trajectories::drawBackground()
+{
+	m_floor_plan = Color_BLACK;
+	for (int mm = -m_half_size; mm <= m_half_size; mm += 1000)
+	{
+		Sample a = { 0, 0, (float) mm, (float) -m_half_size }, b = { 0, 0, (float) mm, (float) m_half_size };
+		line(m_floor_plan, toPlan(a), toPlan(b), Scalar(64, 64, 64));
+		Sample c = { 0, 0, (float) -m_half_size, (float) mm }, d = { 0, 0, (float) m_half_size, (float) mm };
+		line(m_floor_plan, toPlan(c), toPlan(d), Scalar(64, 64, 64));
+	}
+}
+
+/**
+ * Add the position of person id in a frame and draw the new piece of path
+ * Only consecutive frames are connected, a jump (seeking) starts a new piece.
+ * A frame before the track's last one (the video looped, or seeking back)
+ * starts a new pass, so the samples stay ordered by (pass, frame). The same
+ * frame processed again is ignored.
+ */
+void Trajectories::add(
+		int frame, int id, const Point2f &position)
+{
+	if (id < 0) return;
+
+	lock_guard<mutex> lock(m_mutex);
+	if (id >= (int) m_tracks.size()) m_tracks.resize(id + 1);
+
+	vector<Sample> &track = m_tracks[id];
+	if (!track.empty() && frame == track.back().frame) return;
+
+	const int pass = track.empty() ? 0 : track.back().pass + (frame < track.back().frame);
+	Sample sample = { pass, frame, position.x, position.y };
+
+	if (!track.empty() && track.back().pass == pass && track.back().frame == frame - 1)
+		line(m_floor_plan, toPlan(track.back()), toPlan(sample), color(id), 1, CV_AA);
+	else
+		circle(m_floor_plan, toPlan(sample), 2, color(id), -1, CV_AA);
+
+	track.push_back(sample);
+	m_version++;
+}
+
+/**
+ * Forget all trajectories
+ */
+void Trajectories::clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_tracks.clear();
+	drawBackground();
+	m_version++;
+}
+
+/**
+ * Copy the floor plan if it changed since the given version
+ * Returns false (and leaves plan alone) if it didn't
+ */
+bool Trajectories::getFloorPlan(
+		Mat &plan, unsigned &version) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	if (version == m_version && !plan.empty()) return false;
+
+	m_floor_plan.copyTo(plan);
+	version = m_version;
+	return true;
+}
+
+/**
+ * One line per sample: person,pass,frame,x,y
+ */
+bool Trajectories::writeCsv(
+		const string &filename) const
+{
+	ofstream out(filename.c_str());
+	if (!out.is_open()) return false;
+
+	lock_guard<mutex> lock(m_mutex);
+	out << "person,pass,frame,x,y\n";
+	for (size_t id = 0; id < m_tracks.size(); ++id)
+		for (size_t s = 0; s < m_tracks[id].size(); ++s)
+			out << id << "," << m_tracks[id][s].pass << "," << m_tracks[id][s].frame << "," << m_tracks[id][s].x << "," << m_tracks[id][s].y << "\n";
+
+	return out.good();
+}
+
+/**
+ * Little endian int32 person count, then per person an int32 sample count
+ * followed by the samples (int32 pass, int32 frame, float32 x, float32 y)
+ */
+bool Trajectories::writeBinary(
+		const string &filename) const
+{
+	ofstream out(filename.c_str(), ios::binary);
+	if (!out.is_open()) return false;
+
+	lock_guard<mutex> lock(m_mutex);
+	write32(out, (uint32_t) m_tracks.size());
+	for (size_t id = 0; id < m_tracks.size(); ++id)
+	{
+		write32(out, (uint32_t) m_tracks[id].size());
+		for (size_t s = 0; s < m_tracks[id].size(); ++s)
+		{
+			const Sample &sample = m_tracks[id][s];
+			write32(out, (uint32_t) sample.pass);
+			write32(out, (uint32_t) sample.frame);
+			writeFloat(out, sample.x);
+			writeFloat(out, sample.y);
+		}
+	}
+
+	return out.good();
+}
+
+/**
+ * Person colors, the same as the voxels of the person in the 3D scene
+ */
+Scalar Trajectories::color(
+		int id)
+{
+	switch (id)
+	{
+	case 0:
+		return Color_BLUE;
+	case 1:
+		return Color_YELLOW;
+	case 2:
+		return Color_GREEN;
+	case 3:
+		return Color_CYAN;
+	default:
+		return Color_WHITE;
+	}
+}
+
+} /* namespace nl_uu_science_gmt */
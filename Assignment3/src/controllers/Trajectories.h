@@ -0,0 +1,74 @@
+/*
+ * Trajectories.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef TRAJECTORIES_H_
+#define TRAJECTORIES_H_
+
+#include <opencv2/core/core.hpp>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Where every person walked: the floor positions of the tracks per frame,
+ * plus a floor plan image with the paths. New positions only draw the line
+ * from the previous position, so a frame costs the same at the start of a
+ * session as after an hour of tracking.
+ *
+ * Filled by the cluster thread, the floor plan is read by the display thread.
+ */
+class Trajectories
+{
+public:
+	struct Sample
+	{
+		int pass;                               // Pass over the video, a new one starts when the frames go back (looping, seeking back)
+		int frame;                              // Video frame index
+		float x, y;                             // Floor position (mm)
+	};
+
+private:
+	const int m_half_size;                  // The floor plan shows [-m_half_size, m_half_size] mm on both axes
+	const double m_scale;                   // Floor plan pixels per mm
+
+	std::vector<std::vector<Sample>> m_tracks;  // Samples per person
+	cv::Mat m_floor_plan;                   // Paths drawn so far
+	unsigned m_version;                     // Incremented with every change of the floor plan
+
+	mutable std::mutex m_mutex;
+
+	cv::Point toPlan(
+			const Sample &) const;
+	void drawBackground();
+
+public:
+	Trajectories(
+			int, int = 512);
+	virtual ~Trajectories();
+
+	void add(
+			int, int, const cv::Point2f &);
+	void clear();
+
+	bool getFloorPlan(
+			cv::Mat &, unsigned &) const;
+
+	bool writeCsv(
+			const std::string &) const;
+	bool writeBinary(
+			const std::string &) const;
+
+	static cv::Scalar color(
+			int);
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* TRAJECTORIES_H_ */
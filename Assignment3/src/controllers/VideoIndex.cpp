@@ -0,0 +1,206 @@
+/*
+ * VideoIndex.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "VideoIndex.h"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "../utilities/General.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+static const uint32_t AVIIF_KEYFRAME = 0x10;
+
+/**
+ * Little endian 32 bit value
+ */
+static bool read32(
+		istream &in, uint32_t &value)
+{
+	unsigned char bytes[4];
+	if (!in.read((char*) bytes, 4)) return false;
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+	return true;
+}
+
+/**
+ * Chunk header: four character code and size of the data
+ */
+static bool readChunk(
+		istream &in, char id[4], uint32_t &size)
+{
+	return in.read(id, 4) && read32(in, size);
+}
+
+VideoIndex::VideoIndex() :
+		m_file_size(-1),
+		m_frames(0)
+{
+}
+
+VideoIndex::~VideoIndex()
+{
+}
+
+/**
+ * Load the cached index of a video, or build it and cache it when there is
+ * none or it belongs to another version of the video
+ */
+bool VideoIndex::open(
+		const string &video_file, const string &index_file)
+{
+	if (load(index_file) && m_file_size == General::fsize(video_file)) return true;
+
+	cout << "Indexing video: " << video_file << endl;
+	if (!build(video_file)) return false;
+	if (!save(index_file)) cerr << "Unable to write: " << index_file << endl;
+	return true;
+}
+
+/**
+ * Index a video from its idx1 chunk. Without one (not an AVI, or an OpenDML
+ * AVI with only a super index) the frames are counted by reading through the
+ * video and the keyframes stay unknown.
+ *
+ * An OpenDML AVI (over 1 GB) continues in RIFF AVIX chunks after the first
+ * RIFF chunk, its idx1 only covers the first one. Such a video, or one whose
+ * idx1 disagrees with the frame count the video reader reports, is counted by
+ * reading through it as well.
+ */
+bool VideoIndex::build(
+		const string &video_file)
+{
+	m_file_size = General::fsize(video_file);
+	m_frames = 0;
+	m_keyframes.clear();
+
+	ifstream in(video_file.c_str(), ios::binary);
+	char id[4], type[4];
+	uint32_t size;
+	bool indexed = false;
+	if (readChunk(in, id, size) && memcmp(id, "RIFF", 4) == 0 && in.read(type, 4) && memcmp(type, "AVI ", 4) == 0)
+	{
+		const long long riff_end = 8 + (long long) size + (size & 1);
+
+		// Top level chunks: the LIST hdrl and movi chunks, then idx1
+		while (!indexed && readChunk(in, id, size))
+		{
+			if (memcmp(id, "idx1", 4) != 0)
+			{
+				in.seekg(size + (size & 1), ios::cur);
+				continue;
+			}
+
+			// Entries of 16 bytes: chunk id, flags, offset and size
+			for (uint32_t e = 0; e < size / 16; ++e)
+			{
+				char chunk[4];
+				uint32_t flags, offset, length;
+				if (!in.read(chunk, 4) || !read32(in, flags) || !read32(in, offset) || !read32(in, length)) break;
+				if (chunk[2] != 'd' || (chunk[3] != 'c' && chunk[3] != 'b')) continue;
+
+				if (flags & AVIIF_KEYFRAME) m_keyframes.push_back(m_frames);
+				++m_frames;
+			}
+			indexed = m_frames > 0;
+		}
+
+		// Another RIFF chunk after the first one: OpenDML
+		in.clear();
+		in.seekg(riff_end);
+		if (indexed && readChunk(in, id, size) && memcmp(id, "RIFF", 4) == 0 && in.read(type, 4) && memcmp(type, "AVIX", 4) == 0)
+			indexed = false;
+	}
+	in.close();
+
+	VideoCapture video(video_file);
+	if (!video.isOpened()) return false;
+
+	const int reported = (int) video.get(CAP_PROP_FRAME_COUNT);
+	if (indexed && reported > 0 && reported != m_frames) indexed = false;
+
+	if (!indexed)
+	{
+		m_frames = 0;
+		m_keyframes.clear();
+
+		while (video.grab())
+			++m_frames;
+	}
+
+	// A video always starts with a keyframe, decoding can start there
+	if (!m_keyframes.empty() && m_keyframes.front() != 0) m_keyframes.insert(m_keyframes.begin(), 0);
+
+	return m_frames > 0;
+}
+
+/**
+ * Read an index stored by save()
+ */
+bool VideoIndex::load(
+		const string &file)
+{
+	FileStorage fs;
+	if (!fs.open(file, FileStorage::READ)) return false;
+
+	double file_size = -1;
+	int frames = 0;
+	vector<int> keyframes;
+	fs["FileSize"] >> file_size;
+	fs["Frames"] >> frames;
+	fs["Keyframes"] >> keyframes;
+	fs.release();
+
+	if (frames <= 0) return false;
+
+	m_file_size = (long long) file_size;
+	m_frames = frames;
+	m_keyframes = keyframes;
+	return true;
+}
+
+/**
+ * Cache the index, so the video only has to be indexed once
+ */
+bool VideoIndex::save(
+		const string &file) const
+{
+	FileStorage fs;
+	if (!fs.open(file, FileStorage::WRITE)) return false;
+
+	// FileStorage has no 64 bit integers, a double holds any file size exactly
+	fs << "FileSize" << (double) m_file_size;
+	fs << "Frames" << m_frames;
+	fs << "Keyframes" << m_keyframes;
+	fs.release();
+	return true;
+}
+
+/**
+ * Last keyframe at or before a frame, where decoding it has to start
+ * With unknown keyframes that is the frame itself (every seek goes through
+ * the video reader)
+ */
+int VideoIndex::keyframeBefore(
+		int frame) const
+{
+	if (m_keyframes.empty()) return frame;
+	const vector<int>::const_iterator next = upper_bound(m_keyframes.begin(), m_keyframes.end(), frame);
+	return next == m_keyframes.begin() ? 0 : *(next - 1);
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,68 @@
+/*
+ * VideoIndex.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef VIDEOINDEX_H_
+#define VIDEOINDEX_H_
+
+#include <string>
+#include <vector>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Frame count and keyframes of an AVI video, read from the file's idx1
+ * chunk (one entry per stream chunk, video chunks are ##dc or ##db and
+ * flagged when they are a keyframe) without decoding anything.
+ *
+ * A seek has to decode from the last keyframe up to the requested frame, with
+ * the keyframes known the camera can decode on from where it is instead when
+ * that is closer (see Camera::setVideoFrame()). Building the index reads the
+ * whole idx1 chunk, so it is cached next to the video, together with the
+ * video's size to notice a replaced video.
+ */
+class VideoIndex
+{
+	long long m_file_size;                  // Bytes of the indexed video
+	int m_frames;                           // Video frames
+	std::vector<int> m_keyframes;           // Keyframe numbers, ascending (empty: unknown)
+
+public:
+	VideoIndex();
+	virtual ~VideoIndex();
+
+	bool open(
+			const std::string &, const std::string &);
+	bool build(
+			const std::string &);
+	bool load(
+			const std::string &);
+	bool save(
+			const std::string &) const;
+
+	int keyframeBefore(
+			int) const;
+
+	bool empty() const
+	{
+		return m_frames <= 0;
+	}
+
+	int getFrames() const
+	{
+		return m_frames;
+	}
+
+	const std::vector<int>& getKeyframes() const
+	{
+		return m_keyframes;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* VIDEOINDEX_H_ */
@@ -0,0 +1,263 @@
+/*
+ * BitMask.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "BitMask.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITMASK_SSE2
+#endif
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Split a kernel (CV_8U, non-zero is part of the element) into horizontal runs
+ * The default anchor is the kernel center, as with OpenCV
+ */
+BitMask::Element::Element(
+		const Mat &kernel, Point anchor)
+{
+	assert(kernel.type() == CV_8U && kernel.cols <= 64);
+	if (anchor.x < 0) anchor.x = kernel.cols / 2;
+	if (anchor.y < 0) anchor.y = kernel.rows / 2;
+
+	for (int y = 0; y < kernel.rows; ++y)
+	{
+		const uchar* k = kernel.ptr<uchar>(y);
+		for (int x = 0; x < kernel.cols; ++x)
+		{
+			if (!k[x]) continue;
+
+			const int first = x;
+			while (x + 1 < kernel.cols && k[x + 1])
+				++x;
+
+			const Vec2i span(first - anchor.x, x - anchor.x);
+			const int s = (int) (find(m_spans.begin(), m_spans.end(), span) - m_spans.begin());
+			if (s == (int) m_spans.size()) m_spans.push_back(span);
+
+			Run run = { y - anchor.y, s };
+			m_runs.push_back(run);
+		}
+	}
+}
+
+BitMask::BitMask() :
+		m_rows(0),
+		m_cols(0),
+		m_stride(0)
+{
+}
+
+BitMask::BitMask(
+		int rows, int cols)
+{
+	create(rows, cols);
+}
+
+/**
+ * Resize to rows x cols, all pixels 0
+ * The memory is kept when the mask doesn't grow
+ */
+void BitMask::create(
+		int rows, int cols)
+{
+	m_rows = rows;
+	m_cols = cols;
+	m_stride = (cols + 63) / 64;
+	m_words.assign((size_t) m_rows * m_stride, 0);
+}
+
+/**
+ * Copy count rows, from row first on, to row dst_first on of dst (as wide as this mask)
+ */
+void BitMask::copyRows(
+		int first, int count, BitMask &dst, int dst_first) const
+{
+	assert(dst.m_cols == m_cols && first + count <= m_rows && dst_first + count <= dst.m_rows);
+	if (count <= 0) return;
+	copy(row(first), row(first) + (size_t) count * m_stride, dst.row(dst_first));
+}
+
+/**
+ * Pack an 8 bit mask, every non-zero pixel is set
+ */
+void BitMask::fromMat(
+		const Mat &mask)
+{
+	assert(mask.type() == CV_8U);
+	if (mask.rows != m_rows || mask.cols != m_cols) create(mask.rows, mask.cols);
+
+	for (int y = 0; y < m_rows; ++y)
+	{
+		const uchar* pixel = mask.ptr<uchar>(y);
+		uint64_t* words = row(y);
+		int x = 0;
+#ifdef BITMASK_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for (; x + 64 <= m_cols; x += 64)
+		{
+			uint64_t word = 0;
+			for (int b = 0; b < 64; b += 16)
+			{
+				const __m128i v = _mm_loadu_si128((const __m128i*) (pixel + x + b));
+				const uint64_t zeros = (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+				word |= (~zeros & 0xFFFF) << b;
+			}
+			words[x >> 6] = word;
+		}
+#endif
+		for (; x < m_cols; x += 64)
+		{
+			const int bits = min(64, m_cols - x);
+			uint64_t word = 0;
+			for (int b = 0; b < bits; ++b)
+				word |= (uint64_t) (pixel[x + b] != 0) << b;
+			words[x >> 6] = word;
+		}
+	}
+}
+
+/**
+ * Unpack to an 8 bit mask of 0 and 255, for display and OpenCV
+ */
+void BitMask::toMat(
+		Mat &mask) const
+{
+	mask.create(m_rows, m_cols, CV_8U);
+	for (int y = 0; y < m_rows; ++y)
+	{
+		const uint64_t* words = row(y);
+		uchar* pixel = mask.ptr<uchar>(y);
+		for (int x = 0; x < m_cols; ++x)
+			pixel[x] = (uchar) (0 - ((words[x >> 6] >> (x & 63)) & 1));
+	}
+}
+
+/**
+ * Word i of a row shifted by d pixels (bit x of the result is pixel x + d),
+ * pixels beyond the row ends are fill
+ */
+static inline uint64_t shifted(
+		const uint64_t* words, int stride, int i, int d, uint64_t fill)
+{
+	if (d == 0) return words[i];
+	if (d > 0)
+	{
+		const uint64_t next = i + 1 < stride ? words[i + 1] : fill;
+		return (words[i] >> d) | (next << (64 - d));
+	}
+	const uint64_t previous = i > 0 ? words[i - 1] : fill;
+	return (words[i] << -d) | (previous >> (64 + d));
+}
+
+/**
+ * Erosion (AND) or dilation (OR) with element
+ * First every distinct horizontal run of the element is applied to all rows,
+ * then the runs of the element rows are combined per word. src and dst may
+ * be the same mask, the intermediate rows live in scratch.
+ */
+void BitMask::morphology(
+		const BitMask &src, BitMask &dst, const Element &element, bool erode, Scratch &scratch)
+{
+	assert(!element.empty());
+	const int rows = src.m_rows, stride = src.m_stride;
+	const uint64_t fill = erode ? ~(uint64_t) 0 : 0;
+	const uint64_t last = src.lastWordMask();
+
+	// Reuses the memory of the previous call
+	vector<BitMask> &spans = scratch.spans;
+	vector<uint64_t> &line = scratch.line;
+	spans.resize(element.m_spans.size());
+	for (size_t s = 0; s < spans.size(); ++s)
+		spans[s].create(rows, src.m_cols);
+	line.resize(stride);
+	for (int y = 0; y < rows; ++y)
+	{
+		// The padding bits of the last word are outside the image too
+		copy(src.row(y), src.row(y) + stride, line.begin());
+		line[stride - 1] = (line[stride - 1] & last) | (fill & ~last);
+
+		for (size_t s = 0; s < element.m_spans.size(); ++s)
+		{
+			const Vec2i &span = element.m_spans[s];
+			uint64_t* out = spans[s].row(y);
+			for (int i = 0; i < stride; ++i)
+			{
+				uint64_t word = shifted(&line[0], stride, i, span[0], fill);
+				for (int d = span[0] + 1; d <= span[1]; ++d)
+				{
+					const uint64_t other = shifted(&line[0], stride, i, d, fill);
+					word = erode ? (word & other) : (word | other);
+				}
+				out[i] = word;
+			}
+		}
+	}
+
+	if (dst.m_rows != rows || dst.m_cols != src.m_cols) dst.create(rows, src.m_cols);
+	for (int y = 0; y < rows; ++y)
+	{
+		uint64_t* out = dst.row(y);
+		fill_n(out, stride, fill);
+		for (size_t r = 0; r < element.m_runs.size(); ++r)
+		{
+			const int yy = y + element.m_runs[r].dy;
+			if (yy < 0 || yy >= rows) continue;
+
+			const uint64_t* words = spans[element.m_runs[r].span].row(yy);
+			if (erode)
+				for (int i = 0; i < stride; ++i)
+					out[i] &= words[i];
+			else
+				for (int i = 0; i < stride; ++i)
+					out[i] |= words[i];
+		}
+		out[stride - 1] &= last;
+	}
+}
+
+void BitMask::erode(
+		const BitMask &src, BitMask &dst, const Element &element, Scratch &scratch)
+{
+	morphology(src, dst, element, true, scratch);
+}
+
+void BitMask::dilate(
+		const BitMask &src, BitMask &dst, const Element &element, Scratch &scratch)
+{
+	morphology(src, dst, element, false, scratch);
+}
+
+/**
+ * Erode, then dilate: removes specks smaller than the element
+ */
+void BitMask::open(
+		const BitMask &src, BitMask &dst, const Element &element, Scratch &scratch)
+{
+	morphology(src, dst, element, true, scratch);
+	morphology(dst, dst, element, false, scratch);
+}
+
+/**
+ * Dilate, then erode: fills holes smaller than the element
+ */
+void BitMask::close(
+		const BitMask &src, BitMask &dst, const Element &element, Scratch &scratch)
+{
+	morphology(src, dst, element, false, scratch);
+	morphology(dst, dst, element, true, scratch);
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,206 @@
+/*
+ * BitMask.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef BITMASK_H_
+#define BITMASK_H_
+
+#include <opencv2/core/core.hpp>
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Binary image with 1 bit per pixel, 64 pixels per word (pixel x of a row is
+ * bit x % 64 of word x / 64, the rows are padded to whole words).
+ *
+ * Erosion and dilation work on whole words: a horizontal run of the
+ * structuring element is a few shifts and ANDs (ORs) of the row words, the
+ * rows of the element are then combined with one AND (OR) per word. Outside
+ * the image is ignored, as with OpenCV's default border.
+ */
+class BitMask
+{
+public:
+	/*
+	 * Structuring element as horizontal runs per row, relative to the anchor
+	 * Build it once from a kernel (getStructuringElement) and reuse it
+	 */
+	class Element
+	{
+		friend class BitMask;
+
+		struct Run
+		{
+			int dy;                                 // Row offset
+			int span;                               // Index in m_spans
+		};
+
+		std::vector<Run> m_runs;
+		std::vector<cv::Vec2i> m_spans;         // Distinct first/last column offsets
+
+	public:
+		Element()
+		{
+		}
+
+		Element(
+				const cv::Mat &, cv::Point = cv::Point(-1, -1));
+
+		bool empty() const
+		{
+			return m_runs.empty();
+		}
+
+		/**
+		 * Rows an erosion or dilation reaches above or below a pixel
+		 */
+		int reach() const
+		{
+			int rows = 0;
+			for (size_t r = 0; r < m_runs.size(); ++r)
+				rows = (std::max)(rows, std::abs(m_runs[r].dy));
+			return rows;
+		}
+	};
+
+private:
+	int m_rows, m_cols;
+	int m_stride;                           // Words per row
+	std::vector<uint64_t> m_words;
+
+	uint64_t lastWordMask() const
+	{
+		const int bits = m_cols & 63;
+		return bits == 0 ? ~(uint64_t) 0 : ((uint64_t) 1 << bits) - 1;
+	}
+
+public:
+	struct Scratch;
+
+private:
+	static void morphology(
+			const BitMask &, BitMask &, const Element &, bool, Scratch &);
+
+public:
+	BitMask();
+	BitMask(
+			int, int);
+
+	void create(
+			int, int);
+
+	void copyRows(
+			int, int, BitMask &, int) const;
+	void fromMat(
+			const cv::Mat &);
+	void toMat(
+			cv::Mat &) const;
+
+	static void erode(
+			const BitMask &, BitMask &, const Element &, Scratch &);
+	static void dilate(
+			const BitMask &, BitMask &, const Element &, Scratch &);
+	static void open(
+			const BitMask &, BitMask &, const Element &, Scratch &);
+	static void close(
+			const BitMask &, BitMask &, const Element &, Scratch &);
+
+	bool empty() const
+	{
+		return m_words.empty();
+	}
+
+	int rows() const
+	{
+		return m_rows;
+	}
+
+	int cols() const
+	{
+		return m_cols;
+	}
+
+	cv::Size size() const
+	{
+		return cv::Size(m_cols, m_rows);
+	}
+
+	int stride() const
+	{
+		return m_stride;
+	}
+
+	/**
+	 * Bits per (padded) row of a mask cols wide, pixel (x, y) is bit y * rowBits(cols) + x
+	 */
+	static int rowBits(
+			int cols)
+	{
+		return (cols + 63) / 64 * 64;
+	}
+
+	/**
+	 * Pixel at a bit index (see rowBits()), for lookup tables of pixel positions
+	 */
+	static bool test(
+			const uint64_t* words, int bit)
+	{
+		return (words[bit >> 6] >> (bit & 63)) & 1;
+	}
+
+	const uint64_t* data() const
+	{
+		return m_words.empty() ? NULL : &m_words[0];
+	}
+
+	uint64_t* row(
+			int y)
+	{
+		return &m_words[y * m_stride];
+	}
+
+	const uint64_t* row(
+			int y) const
+	{
+		return &m_words[y * m_stride];
+	}
+
+	bool get(
+			int x, int y) const
+	{
+		return (m_words[y * m_stride + (x >> 6)] >> (x & 63)) & 1;
+	}
+
+	void set(
+			int x, int y, bool value)
+	{
+		uint64_t &word = m_words[y * m_stride + (x >> 6)];
+		const uint64_t bit = (uint64_t) 1 << (x & 63);
+		word = value ? (word | bit) : (word & ~bit);
+	}
+};
+
+/*
+ * Working memory of the morphology. Keep one per thread that cleans masks
+ * (e.g. per band, see ChangeDetector::getScratch()) and pass it to every
+ * call: once its masks have grown to the image size, cleaning a mask
+ * allocates nothing.
+ */
+struct BitMask::Scratch
+{
+	std::vector<BitMask> spans;             // Every distinct run of the element applied to every row
+	std::vector<uint64_t> line;             // Source row with the padding bits filled in
+	BitMask band;                           // Rows being cleaned, with their halo
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* BITMASK_H_ */
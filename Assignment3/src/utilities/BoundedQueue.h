@@ -0,0 +1,122 @@
+/*
+ * BoundedQueue.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef BOUNDEDQUEUE_H_
+#define BOUNDEDQUEUE_H_
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Fixed capacity FIFO connecting two threads
+ * push() blocks while the queue is full and pop() blocks while it is empty,
+ * close() wakes up every waiting thread so a stage can shut down
+ */
+template<typename T>
+class BoundedQueue
+{
+	std::deque<T> m_items;                   // Queued items, front is the oldest
+	size_t m_capacity;                       // Maximum amount of queued items
+	bool m_closed;                           // flag queue no longer accepts or hands out items
+
+	std::mutex m_mutex;
+	std::condition_variable m_not_full;
+	std::condition_variable m_not_empty;
+
+public:
+	BoundedQueue(
+			size_t capacity) :
+				m_capacity(capacity > 0 ? capacity : 1),
+				m_closed(false)
+	{
+	}
+
+	/**
+	 * Append an item, waits for space; returns false if the queue was closed
+	 */
+	bool push(
+			const T &item)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_closed && m_items.size() >= m_capacity)
+			m_not_full.wait(lock);
+		if (m_closed) return false;
+
+		m_items.push_back(item);
+		m_not_empty.notify_one();
+		return true;
+	}
+
+	/**
+	 * Take the oldest item, waits for one; returns false if the queue was closed
+	 */
+	bool pop(
+			T &item)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_closed && m_items.empty())
+			m_not_empty.wait(lock);
+		if (m_closed) return false;
+
+		item = m_items.front();
+		m_items.pop_front();
+		m_not_full.notify_one();
+		return true;
+	}
+
+	/**
+	 * Take the oldest item if there is one, never waits (also works on a closed queue)
+	 */
+	bool tryPop(
+			T &item)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_items.empty()) return false;
+
+		item = m_items.front();
+		m_items.pop_front();
+		m_not_full.notify_one();
+		return true;
+	}
+
+	/**
+	 * Release all threads waiting in push() or pop()
+	 */
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+		m_not_full.notify_all();
+		m_not_empty.notify_all();
+	}
+
+	/**
+	 * Make a closed (and drained) queue usable again
+	 */
+	void reopen(
+			size_t capacity)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_capacity = capacity > 0 ? capacity : 1;
+		m_closed = false;
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_items.size();
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* BOUNDEDQUEUE_H_ */
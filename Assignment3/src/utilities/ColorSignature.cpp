@@ -0,0 +1,124 @@
+/*
+ * ColorSignature.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#include "ColorSignature.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLORSIGNATURE_SSE2
+#endif
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * The bin of every 15 bit BGR color, with OpenCV's 8 bit HSV scale
+ * (hue 0-180, saturation 0-255) at the center of the color's cell
+ */
+static const unsigned char* buildLut()
+{
+	static unsigned char lut[1 << 15];
+	for (int i = 0; i < (1 << 15); ++i)
+	{
+		const int b = ((i >> 10) << 3) + 4, g = (((i >> 5) & 31) << 3) + 4, r = ((i & 31) << 3) + 4;
+		const int v = max(b, max(g, r));
+		const int delta = v - min(b, min(g, r));
+
+		float h = 0;
+		if (delta > 0)
+		{
+			if (v == r)
+				h = 30.f * (g - b) / delta;
+			else if (v == g)
+				h = 60.f + 30.f * (b - r) / delta;
+			else
+				h = 120.f + 30.f * (r - g) / delta;
+			if (h < 0) h += 180;
+		}
+		const int s = 255 * delta / v;
+
+		const int h_bin = min((int) (h * ColorSignature::H_BINS / 180), ColorSignature::H_BINS - 1);
+		const int s_bin = min(s * ColorSignature::S_BINS / 256, ColorSignature::S_BINS - 1);
+		lut[i] = (unsigned char) (h_bin * ColorSignature::S_BINS + s_bin);
+	}
+	return lut;
+}
+
+const unsigned char* const ColorSignature::s_lut = buildLut();
+
+ColorSignature::ColorSignature() :
+		m_samples(0)
+{
+	fill(m_bins, m_bins + BINS, 0.f);
+}
+
+/**
+ * Zero mean, unit length (a signature without samples stays all zero)
+ */
+void ColorSignature::normalize()
+{
+	float mean = 0;
+	for (int i = 0; i < BINS; ++i)
+		mean += m_bins[i];
+	mean /= BINS;
+
+	float length = 0;
+	for (int i = 0; i < BINS; ++i)
+	{
+		m_bins[i] -= mean;
+		length += m_bins[i] * m_bins[i];
+	}
+
+	if (length <= 0) return;
+	length = sqrt(length);
+	for (int i = 0; i < BINS; ++i)
+		m_bins[i] /= length;
+}
+
+/**
+ * Move this (normalized) signature towards another one by rate, and normalize again
+ */
+void ColorSignature::blend(
+		const ColorSignature &other, float rate)
+{
+	for (int i = 0; i < BINS; ++i)
+		m_bins[i] = (1 - rate) * m_bins[i] + rate * other.m_bins[i];
+	m_samples += other.m_samples;
+	normalize();
+}
+
+/**
+ * 1 - correlation of two normalized signatures, 0 (same colors) to 2
+ */
+float ColorSignature::distance(
+		const ColorSignature &other) const
+{
+#ifdef COLORSIGNATURE_SSE2
+	__m128 sum = _mm_setzero_ps();
+	for (int i = 0; i < BINS; i += 4)
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(m_bins + i), _mm_loadu_ps(other.m_bins + i)));
+
+	// Horizontal add of the 4 lanes
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	const float dot = _mm_cvtss_f32(sum);
+#else
+	float dot = 0;
+	for (int i = 0; i < BINS; ++i)
+		dot += m_bins[i] * other.m_bins[i];
+#endif
+
+	return 1 - dot;
+}
+
+} /* namespace nl_uu_science_gmt */
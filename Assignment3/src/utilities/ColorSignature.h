@@ -0,0 +1,87 @@
+/*
+ * ColorSignature.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: rick
+ */
+
+#ifndef COLORSIGNATURE_H_
+#define COLORSIGNATURE_H_
+
+#include <opencv2/core/core.hpp>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Appearance of a person: a small hue/saturation histogram (16x4 bins)
+ * filled straight from pixel samples. The pixels are binned through a
+ * lookup table on 15 bit BGR, so no color conversion or intermediate image
+ * is needed.
+ *
+ * After normalize() the bins have zero mean and unit length, the distance of
+ * two signatures is then 1 - correlation (0: same, 2: opposite), a 64 float
+ * dot product evaluated with SSE2.
+ */
+class ColorSignature
+{
+public:
+	static const int H_BINS = 16;           // Hue bins
+	static const int S_BINS = 4;            // Saturation bins
+	static const int BINS = H_BINS * S_BINS;
+
+private:
+	float m_bins[BINS];                     // Pixel counts, after normalize() zero mean and unit length
+	int m_samples;                          // Amount of pixels added
+
+	static const unsigned char* const s_lut;  // Bin per 15 bit BGR color (5 bits per channel)
+
+public:
+	ColorSignature();
+
+	/**
+	 * Count a BGR pixel
+	 */
+	void add(
+			const cv::Vec3b &pixel)
+	{
+		m_bins[s_lut[((pixel[0] >> 3) << 10) | ((pixel[1] >> 3) << 5) | (pixel[2] >> 3)]]++;
+		m_samples++;
+	}
+
+	/**
+	 * Add the pixel counts of another signature, both must not be normalized yet
+	 */
+	void merge(
+			const ColorSignature &other)
+	{
+		for (int i = 0; i < BINS; ++i)
+			m_bins[i] += other.m_bins[i];
+		m_samples += other.m_samples;
+	}
+
+	void normalize();
+	void blend(
+			const ColorSignature &, float);
+	float distance(
+			const ColorSignature &) const;
+
+	bool empty() const
+	{
+		return m_samples == 0;
+	}
+
+	int getSamples() const
+	{
+		return m_samples;
+	}
+
+	const float* getBins() const
+	{
+		return m_bins;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* COLORSIGNATURE_H_ */
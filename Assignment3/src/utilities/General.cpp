@@ -18,10 +18,16 @@ const string General::CBConfigFile         = "checkerboard.xml";
 const string General::CalibrationVideo     = "calibration.avi";
 const string General::CheckerboadVideo     = "checkerboard.avi";
 const string General::BackgroundImageFile  = "background.png";
+const string General::BackgroundVideoFile  = "background.avi";
+const string General::BackgroundModelFile  = "background_model.xml";
 const string General::VideoFile            = "video.avi";
+const string General::VideoIndexFile       = "video_index.xml";
+const string General::RawVideoFile         = "video.raw";
 const string General::IntrinsicsFile       = "intrinsics.xml";
 const string General::CheckerboadCorners   = "boardcorners.xml";
 const string General::ConfigFile           = "config.xml";
+const string General::TrajectoriesCsvFile  = "trajectories.csv";
+const string General::TrajectoriesFile     = "trajectories.bin";
 
 /**
  * Linux/Windows friendly way to check if a file exists
@@ -32,4 +38,13 @@ bool General::fexists(const std::string &filename)
 	return ifile.is_open();
 }
 
+/**
+ * Size of a file in bytes, -1 if it can't be opened
+ */
+long long General::fsize(const std::string &filename)
+{
+	ifstream ifile(filename.c_str(), ios::binary | ios::ate);
+	return ifile.is_open() ? (long long) ifile.tellg() : -1;
+}
+
 } /* namespace nl_uu_science_gmt */
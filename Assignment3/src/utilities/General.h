@@ -21,6 +21,7 @@ namespace nl_uu_science_gmt
 const static std::string VERSION = "2.5";
 const static std::string VIDEO_WINDOW = "Video";
 const static std::string SCENE_WINDOW = "OpenGL 3D scene";
+const static std::string FLOOR_WINDOW = "Floor plan";
 
 // Some OpenCV colors
 const static cv::Scalar Color_BLUE = cv::Scalar(255, 0, 0);
@@ -41,10 +42,17 @@ public:
 	static const std::string CheckerboadVideo;
 	static const std::string CheckerboadCorners;
 	static const std::string VideoFile;
+	static const std::string VideoIndexFile;
+	static const std::string RawVideoFile;
 	static const std::string BackgroundImageFile;
+	static const std::string BackgroundVideoFile;
+	static const std::string BackgroundModelFile;
 	static const std::string ConfigFile;
+	static const std::string TrajectoriesCsvFile;
+	static const std::string TrajectoriesFile;
 
 	static bool fexists(const std::string &);
+	static long long fsize(const std::string &);
 };
 
 } /* namespace nl_uu_science_gmt */